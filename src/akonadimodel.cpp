@@ -48,6 +48,7 @@
 #include <AkonadiCore/itemmodifyjob.h>
 #include <AkonadiCore/itemdeletejob.h>
 #include <AkonadiCore/itemfetchscope.h>
+#include <AkonadiCore/transactionsequence.h>
 #include <AkonadiWidgets/agenttypedialog.h>
 
 #include <KLocalizedString>
@@ -63,6 +64,7 @@ using namespace Akonadi;
 using namespace KAlarmCal;
 
 static const Collection::Rights writableRights = Collection::CanChangeItem | Collection::CanCreateItem | Collection::CanDeleteItem;
+static const int COMMAND_ERROR_WRITE_DELAY = 1000;   // milliseconds to coalesce command error status changes
 
 //static bool checkItem_true(const Item&) { return true; }
 
@@ -132,6 +134,7 @@ AkonadiModel::AkonadiModel(ChangeRecorder* monitor, QObject* parent)
     connect(monitor, &Monitor::collectionRemoved, this, &AkonadiModel::slotCollectionRemoved);
     initCalendarMigrator();
     MinuteTimer::connect(this, SLOT(slotUpdateTimeTo()));
+    enableTimeToUpdates(false);    // until a view displays the time-to-alarm values
     Preferences::connect(SIGNAL(archivedColourChanged(QColor)), this, SLOT(slotUpdateArchivedColour(QColor)));
     Preferences::connect(SIGNAL(disabledColourChanged(QColor)), this, SLOT(slotUpdateDisabledColour(QColor)));
     Preferences::connect(SIGNAL(holidaysChanged(KHolidays::HolidayRegion)), this, SLOT(slotUpdateHolidays()));
@@ -141,6 +144,11 @@ AkonadiModel::AkonadiModel(ChangeRecorder* monitor, QObject* parent)
     connect(this, &AkonadiModel::rowsAboutToBeRemoved, this, &AkonadiModel::slotRowsAboutToBeRemoved);
     connect(monitor, &Monitor::itemChanged, this, &AkonadiModel::slotMonitoredItemChanged);
 
+    mCommandErrorTimer = new QTimer(this);
+    mCommandErrorTimer->setSingleShot(true);
+    mCommandErrorTimer->setInterval(COMMAND_ERROR_WRITE_DELAY);
+    connect(mCommandErrorTimer, &QTimer::timeout, this, &AkonadiModel::writeCommandErrors);
+
     connect(ServerManager::self(), &ServerManager::stateChanged, this, &AkonadiModel::checkResources);
     checkResources(ServerManager::state());
 }
@@ -765,6 +773,14 @@ void AkonadiModel::slotUpdateTimeTo()
     signalDataChanged(&checkItem_isActive, TimeToColumn, TimeToColumn, QModelIndex());
 }
 
+/******************************************************************************
+* Enable or disable the minute updates of the time-to-alarm values.
+*/
+void AkonadiModel::enableTimeToUpdates(bool enable)
+{
+    MinuteTimer::setSuspended(this, !enable);
+}
+
 
 /******************************************************************************
 * Called when the colour used to display archived alarms has changed.
@@ -846,9 +862,100 @@ void AkonadiModel::slotUpdateWorkingHours()
 */
 void AkonadiModel::updateCommandError(const KAEvent& event)
 {
-    const QModelIndex ix = itemIndex(event.itemId());
-    if (ix.isValid())
-        setData(ix, QVariant(static_cast<int>(event.commandError())), CommandErrorRole);
+    // Record only the latest status for each alarm, and write them all
+    // together after a short delay.
+    mPendingCommandErrors[event.itemId()] = event.commandError();
+    if (!mCommandErrorTimer->isActive())
+        mCommandErrorTimer->start();
+}
+
+/******************************************************************************
+* Called after a delay to write all pending command error statuses to the
+* Akonadi database.
+*/
+void AkonadiModel::writeCommandErrors()
+{
+    commitCommandErrors(false);
+}
+
+/******************************************************************************
+* Write all pending command error statuses to the Akonadi database, and wait
+* for the write to complete.
+*/
+void AkonadiModel::flushCommandErrors()
+{
+    commitCommandErrors(true);
+}
+
+/******************************************************************************
+* Write all pending command error statuses to the Akonadi database, in a single
+* transaction. Statuses which are unchanged from those already stored are not
+* written. Items which already have a modification pending have the change
+* queued behind it instead.
+* If 'wait' is true, wait for the transaction to complete before returning.
+*/
+void AkonadiModel::commitCommandErrors(bool wait)
+{
+    mCommandErrorTimer->stop();
+    const QHash<Item::Id, KAEvent::CmdErrType> pending = mPendingCommandErrors;
+    mPendingCommandErrors.clear();
+    TransactionSequence* transaction = nullptr;
+    QList<Item::Id> itemIds;
+    for (QHash<Item::Id, KAEvent::CmdErrType>::const_iterator it = pending.constBegin();  it != pending.constEnd();  ++it)
+    {
+        const QModelIndex ix = itemIndex(it.key());
+        if (!ix.isValid())
+            continue;
+        if (mItemModifyJobQueue.contains(it.key())  ||  mItemsBeingCreated.contains(it.key()))
+        {
+            // Another change to the item is in progress, so queue this one after it
+            setData(ix, QVariant(static_cast<int>(it.value())), CommandErrorRole);
+            continue;
+        }
+        Item item = ix.data(ItemRole).value<Item>();
+        const KAEvent::CmdErrType err = it.value();
+        if (err == KAEvent::CMD_NO_ERROR  &&  !item.hasAttribute<EventAttribute>())
+            continue;   // no change
+        EventAttribute* attr = item.attribute<EventAttribute>(Item::AddIfMissing);
+        if (attr->commandError() == err)
+            continue;   // no change
+        attr->setCommandError(err);
+        if (!transaction)
+            transaction = new TransactionSequence(this);
+        mItemModifyJobQueue[item.id()] = Item();   // mark a job as now executing for the item
+        ItemModifyJob* job = new ItemModifyJob(item, transaction);
+        job->disableRevisionCheck();
+        itemIds += item.id();
+    }
+    if (!transaction)
+        return;
+    qCDebug(KALARM_LOG) << "Writing" << itemIds.count() << "command error statuses";
+    mCommandErrorTransactions[transaction] = itemIds;
+    connect(transaction, &KJob::result, this, &AkonadiModel::commandErrorsWritten);
+    if (wait)
+        transaction->exec();
+}
+
+/******************************************************************************
+* Called when a transaction writing command error statuses has completed.
+* If it failed, allow any further modifications queued for its items to
+* proceed. (If it succeeded, they proceed once the item changes are notified.)
+*/
+void AkonadiModel::commandErrorsWritten(KJob* j)
+{
+    const QList<Item::Id> itemIds = mCommandErrorTransactions.take(j);
+    if (j->error())
+    {
+        qCCritical(KALARM_LOG) << "Failed to write command error statuses:" << j->errorString();
+        for (Item::Id id : itemIds)
+        {
+            const Item current = itemById(id);    // fetch the up-to-date item
+            if (current.isValid())
+                checkQueuedItemModifyJob(current);
+            else
+                mItemModifyJobQueue.remove(id);
+        }
+    }
 }
 
 /******************************************************************************
@@ -1274,6 +1381,20 @@ KAEvent AkonadiModel::event(const QModelIndex& index) const
     return event(index.data(ItemRole).value<Item>(), index, nullptr);
 }
 
+/******************************************************************************
+* Return the collection and event ID of the alarm at a model index.
+* Unlike event(), this neither sets the collection ID in a copy of the event,
+* nor looks up the item's model index.
+*/
+EventId AkonadiModel::eventId(const QModelIndex& index) const
+{
+    const Item item = index.data(ItemRole).value<Item>();
+    if (!item.isValid()  ||  !item.hasPayload<KAEvent>())
+        return EventId();
+    const Collection c = index.data(ParentCollectionRole).value<Collection>();
+    return EventId(c.id(), item.payload<KAEvent>().id());
+}
+
 KAEvent AkonadiModel::event(const Item& item, const QModelIndex& index, Collection* collection) const
 {
     if (!item.isValid()  ||  !item.hasPayload<KAEvent>())
@@ -1329,15 +1450,42 @@ AkonadiModel::Result AkonadiModel::addEvent(KAEvent* event, CalEvent::Type type,
 * The caller must connect to the itemDone() signal to check whether events
 * have been added successfully. Note that the first signal may be emitted
 * before this function returns.
+* All the items are created within a single Akonadi transaction, so that a
+* large number of events is committed in one go. Since the transaction either
+* succeeds or fails as a whole, itemDone() is only emitted for the events once
+* the transaction has completed.
 * Reply = true if item creation has been scheduled for all events,
-*       = false if at least one item creation failed to be scheduled.
+*       = false if no item creation was scheduled because at least one event
+*         is invalid for the collection.
 */
 bool AkonadiModel::addEvents(const KAEvent::List& events, Collection& collection)
 {
-    bool ok = true;
+    if (events.count() <= 1)
+        return events.isEmpty() || addEvent(*events[0], collection);
+
+    // Check that all the events can be added before scheduling any of them
+    QVector<Item> items(events.count());
     for (int i = 0, count = events.count();  i < count;  ++i)
-        ok = ok && addEvent(*events[i], collection);
-    return ok;
+    {
+        if (!events[i]->setItemPayload(items[i], collection.contentMimeTypes()))
+        {
+            qCWarning(KALARM_LOG) << "Invalid mime type for collection";
+            return false;
+        }
+    }
+
+    TransactionSequence* transaction = new TransactionSequence(this);
+    connect(transaction, &KJob::result, this, &AkonadiModel::createTransactionDone);
+    QList<Item::Id>& itemIds = mPendingCreateTransactions[transaction];
+    for (int i = 0, count = events.count();  i < count;  ++i)
+    {
+        qCDebug(KALARM_LOG) << "ID:" << events[i]->id();
+        events[i]->setItemId(items[i].id());
+        ItemCreateJob* job = new ItemCreateJob(items[i], collection, transaction);
+        connect(job, &ItemCreateJob::result, this, &AkonadiModel::transactionItemCreated);
+        itemIds += items[i].id();
+    }
+    return true;
 }
 
 /******************************************************************************
@@ -1468,6 +1616,42 @@ void AkonadiModel::queueItemModifyJob(const Item& item)
     }
 }
 
+/******************************************************************************
+* Called when an item creation job within a transaction has completed.
+* Record the new item's ID, but don't notify the result until the whole
+* transaction has completed, since it may yet be rolled back.
+*/
+void AkonadiModel::transactionItemCreated(KJob* j)
+{
+    if (!j->error())
+        mTransactionItemsCreated[j->parent()] += static_cast<ItemCreateJob*>(j)->item().id();
+}
+
+/******************************************************************************
+* Called when a transaction creating items has completed.
+* Notify the result for all its items.
+*/
+void AkonadiModel::createTransactionDone(KJob* j)
+{
+    const QList<Item::Id> itemIds = mPendingCreateTransactions.take(j);
+    const QList<Item::Id> created = mTransactionItemsCreated.take(j);
+    if (j->error())
+    {
+        const QString errMsg = i18nc("@info", "Failed to create alarms.");
+        qCCritical(KALARM_LOG) << errMsg << itemIds.count() << "items:" << j->errorString();
+        for (Item::Id id : itemIds)
+            Q_EMIT itemDone(id, false);
+        KAMessageBox::detailedError(MainWindow::mainMainWindow(), errMsg, j->errorString());
+    }
+    else
+    {
+        // Prevent modification of the items until they are fully initialised.
+        mItemsBeingCreated += created;
+        for (Item::Id id : itemIds)
+            Q_EMIT itemDone(id);
+    }
+}
+
 /******************************************************************************
 * Called when an item job has completed.
 * Checks for any error.
@@ -33,13 +33,16 @@
 #include <QColor>
 #include <QMap>
 #include <QQueue>
+#include <QHash>
 
 namespace Akonadi
 {
 class ChangeRecorder;
+class TransactionSequence;
 }
 
 class QPixmap;
+class QTimer;
 class KJob;
 
 using namespace KAlarmCal;
@@ -107,9 +110,22 @@ class AkonadiModel : public Akonadi::EntityTreeModel
 
         /** To be called when the command error status of an alarm has changed,
          *  to set in the Akonadi database and update the visual command error indications.
+         *  Changes are coalesced per alarm and written in batches.
          */
         void updateCommandError(const KAEvent&);
 
+        /** Write any pending command error statuses to the Akonadi database
+         *  immediately, and wait for the write to complete. To be called
+         *  before the application quits.
+         */
+        void flushCommandErrors();
+
+        /** Set whether the "time to alarm" values should be updated every minute.
+         *  Updates should be disabled while no view is displaying them; when
+         *  re-enabled, the values are updated immediately if they are out of date.
+         */
+        void enableTimeToUpdates(bool enable);
+
         QVariant data(const QModelIndex&, int role = Qt::DisplayRole) const override;
         bool setData(const QModelIndex&, const QVariant& value, int role) override;
 
@@ -153,6 +169,9 @@ class AkonadiModel : public Akonadi::EntityTreeModel
         KAEvent event(Akonadi::Item::Id) const;
         KAEvent event(const QModelIndex&) const;
         using QObject::event;   // prevent warning about hidden virtual method
+        /** Return the unique identifier of the alarm at a model index, without
+         *  constructing a separate KAEvent instance. */
+        EventId eventId(const QModelIndex&) const;
 
         /** Return an event's model index, based on its itemId() value. */
         QModelIndex eventIndex(const KAEvent&);
@@ -269,8 +288,12 @@ class AkonadiModel : public Akonadi::EntityTreeModel
         void slotRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end);
         void slotMonitoredItemChanged(const Akonadi::Item&, const QSet<QByteArray>&);
         void slotEmitEventChanged();
+        void writeCommandErrors();
+        void commandErrorsWritten(KJob*);
         void modifyCollectionJobDone(KJob*);
         void itemJobDone(KJob*);
+        void transactionItemCreated(KJob*);
+        void createTransactionDone(KJob*);
 
     private:
         struct CalData   // data per collection
@@ -301,6 +324,7 @@ class AkonadiModel : public Akonadi::EntityTreeModel
         void      signalDataChanged(bool (*checkFunc)(const Akonadi::Item&), int startColumn, int endColumn, const QModelIndex& parent);
         void      setCollectionChanged(const Akonadi::Collection&, const QSet<QByteArray>&, bool rowInserted);
         void      queueItemModifyJob(const Akonadi::Item&);
+        void      commitCommandErrors(bool wait);
         void      checkQueuedItemModifyJob(const Akonadi::Item&);
 #if 0
         void     getChildEvents(const QModelIndex& parent, CalEvent::Type, KAEvent::List&) const;
@@ -328,6 +352,8 @@ class AkonadiModel : public Akonadi::EntityTreeModel
         QMap<KJob*, CollJobData> mPendingCollectionJobs;  // pending collection creation/deletion jobs, with collection ID & name
         QMap<KJob*, CollTypeData> mPendingColCreateJobs;  // default alarm type for pending collection creation jobs
         QMap<KJob*, Akonadi::Item::Id> mPendingItemJobs;  // pending item creation/deletion jobs, with event ID
+        QMap<KJob*, QList<Akonadi::Item::Id> > mPendingCreateTransactions;  // pending item creation transactions, with event IDs
+        QMap<KJob*, QList<Akonadi::Item::Id> > mTransactionItemsCreated;    // items created so far by each pending transaction
         QMap<Akonadi::Item::Id, Akonadi::Item> mItemModifyJobQueue;  // pending item modification jobs, invalid item = queue empty but job active
         QList<QString>     mCollectionsBeingCreated;  // path names of new collections being created by migrator
         QList<Akonadi::Collection::Id> mCollectionIdsBeingCreated;  // ids of new collections being created by migrator
@@ -335,6 +361,9 @@ class AkonadiModel : public Akonadi::EntityTreeModel
         QList<Akonadi::Collection::Id> mCollectionsDeleting;  // collections currently being removed
         QList<Akonadi::Collection::Id> mCollectionsDeleted;   // collections recently removed
         QQueue<Event>   mPendingEventChanges;   // changed events with changedEvent() signal pending
+        QHash<Akonadi::Item::Id, KAEvent::CmdErrType> mPendingCommandErrors;  // command error statuses awaiting write
+        QTimer*         mCommandErrorTimer;     // timer to write pending command error statuses
+        QMap<KJob*, QList<Akonadi::Item::Id> > mCommandErrorTransactions;  // pending command error writes, with item IDs
         bool            mResourcesChecked;      // whether resource existence has been checked yet
         bool            mMigrating;             // currently migrating calendars
 };
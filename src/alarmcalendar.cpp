@@ -38,6 +38,7 @@
 #include <KJobWidgets>
 #include <kfileitem.h>
 #include <KSharedConfig>
+#include <QSet>
 #include <QTemporaryFile>
 #include <QStandardPaths>
 #include <QTimeZone>
@@ -649,69 +650,145 @@ bool AlarmCalendar::importAlarms(QWidget* parent, Collection* collection)
         KAMessageBox::error(parent, xi18nc("@info", "Could not load calendar <filename>%1</filename>.", url.toDisplayString()));
     }
     else
+        success = importCalendar(calStorage, collection);
+    if (!local)
+        QFile::remove(filename);
+    return success;
+}
+
+/******************************************************************************
+* Import the alarms from a loaded external calendar, after converting them to
+* the current KAlarm format if necessary.
+* See importEvents() for a description of the parameters.
+*/
+bool AlarmCalendar::importCalendar(const FileStorage::Ptr& calStorage, Collection* collection,
+                                   bool skipExisting, int* skipped, int* imported)
+{
+    const KACalendar::Compat caltype = fix(calStorage);
+    return importEvents(calStorage->calendar()->rawEvents(), caltype, collection, skipExisting, skipped, imported);
+}
+
+/******************************************************************************
+* Add events read from an external calendar to the current calendars.
+* If 'collection' is non-null, the events are added to that collection if they
+* are of the right type; otherwise each event is added to the default
+* collection for its type.
+* All events destined for the same collection are added in a single Akonadi
+* transaction.
+* If 'skipExisting' is true, events whose UIDs already exist in the resources
+* calendar are skipped, and the imported events retain their UIDs. Otherwise,
+* every imported event is given a new UID.
+* If 'skipped' is non-null, it receives the number of events which already
+* existed. If 'imported' is non-null, it receives the number of events which
+* were added.
+* Reply = true if all events were added successfully.
+*/
+bool AlarmCalendar::importEvents(const Event::List& events, KACalendar::Compat caltype, Collection* collection,
+                                 bool skipExisting, int* skipped, int* imported)
+{
+    bool success = true;
+    if (skipped)
+        *skipped = 0;
+    if (imported)
+        *imported = 0;
+    QSet<QString> existingIds;
+    if (skipExisting  &&  mResourcesCalendar)
+    {
+        // Index the existing event UIDs once, to avoid searching the calendar
+        // for every imported event.
+        for (KAEventMap::ConstIterator it = mResourcesCalendar->mEventMap.constBegin();  it != mResourcesCalendar->mEventMap.constEnd();  ++it)
+            existingIds.insert(it.key().eventId());
+    }
+    CalEvent::Types wantedTypes = collection && collection->isValid() ? CalEvent::types(collection->contentMimeTypes()) : CalEvent::EMPTY;
+    Collection activeColl, archiveColl, templateColl;
+    QVector<KAEvent> newEvents;
+    QVector<Collection*> newEventCollections;
+    newEvents.reserve(events.count());
+    newEventCollections.reserve(events.count());
+    for (int i = 0, end = events.count();  i < end;  ++i)
     {
-        KACalendar::Compat caltype = fix(calStorage);
-        CalEvent::Types wantedTypes = collection && collection->isValid() ? CalEvent::types(collection->contentMimeTypes()) : CalEvent::EMPTY;
-        Collection activeColl, archiveColl, templateColl;
-        Event::List events = cal->rawEvents();
-        for (int i = 0, end = events.count();  i < end;  ++i)
+        Event::Ptr event = events[i];
+        if (event->alarms().isEmpty()  ||  !KAEvent(event).isValid())
+            continue;    // ignore events without alarms, or usable alarms
+        CalEvent::Type type = CalEvent::status(event);
+        if (type == CalEvent::TEMPLATE)
         {
-            Event::Ptr event = events[i];
-            if (event->alarms().isEmpty()  ||  !KAEvent(event).isValid())
-                continue;    // ignore events without alarms, or usable alarms
-            CalEvent::Type type = CalEvent::status(event);
-            if (type == CalEvent::TEMPLATE)
-            {
-                // If we know the event was not created by KAlarm, don't treat it as a template
-                if (caltype == KACalendar::Incompatible)
-                    type = CalEvent::ACTIVE;
-            }
-            Collection* coll;
-            if (collection  &&  collection->isValid())
+            // If we know the event was not created by KAlarm, don't treat it as a template
+            if (caltype == KACalendar::Incompatible)
+                type = CalEvent::ACTIVE;
+        }
+        QString uid;
+        if (skipExisting)
+        {
+            uid = CalEvent::uid(event->uid(), type);
+            if (existingIds.contains(uid))
             {
-                if (!(type & wantedTypes))
-                    continue;
-                coll = collection;
+                if (skipped)
+                    ++*skipped;
+                continue;    // the event is already in the calendar
             }
-            else
+            existingIds.insert(uid);
+        }
+        Collection* coll;
+        if (collection  &&  collection->isValid())
+        {
+            if (!(type & wantedTypes))
+                continue;
+            coll = collection;
+        }
+        else
+        {
+            switch (type)
             {
-                switch (type)
-                {
-                    case CalEvent::ACTIVE:    coll = &activeColl;  break;
-                    case CalEvent::ARCHIVED:  coll = &archiveColl;  break;
-                    case CalEvent::TEMPLATE:  coll = &templateColl;  break;
-                    default:  continue;
-                }
-                if (!coll->isValid())
-                    *coll = CollectionControlModel::destination(type);
+                case CalEvent::ACTIVE:    coll = &activeColl;  break;
+                case CalEvent::ARCHIVED:  coll = &archiveColl;  break;
+                case CalEvent::TEMPLATE:  coll = &templateColl;  break;
+                default:  continue;
             }
+            if (!coll->isValid())
+                *coll = CollectionControlModel::destination(type);
+        }
 
-            Event::Ptr newev(new Event(*event));
+        Event::Ptr newev(new Event(*event));
 
-            // If there is a display alarm without display text, use the event
-            // summary text instead.
-            if (type == CalEvent::ACTIVE  &&  !newev->summary().isEmpty())
+        // If there is a display alarm without display text, use the event
+        // summary text instead.
+        if (type == CalEvent::ACTIVE  &&  !newev->summary().isEmpty())
+        {
+            const Alarm::List& alarms = newev->alarms();
+            for (int ai = 0, aend = alarms.count();  ai < aend;  ++ai)
             {
-                const Alarm::List& alarms = newev->alarms();
-                for (int ai = 0, aend = alarms.count();  ai < aend;  ++ai)
-                {
-                    Alarm::Ptr alarm = alarms[ai];
-                    if (alarm->type() == Alarm::Display  &&  alarm->text().isEmpty())
-                        alarm->setText(newev->summary());
-                }
-                newev->setSummary(QString());   // KAlarm only uses summary for template names
+                Alarm::Ptr alarm = alarms[ai];
+                if (alarm->type() == Alarm::Display  &&  alarm->text().isEmpty())
+                    alarm->setText(newev->summary());
             }
-
-            // Give the event a new ID and add it to the calendars
-            newev->setUid(CalEvent::uid(CalFormat::createUniqueId(), type));
-            KAEvent* newEvent = new KAEvent(newev);
-            if (!AkonadiModel::instance()->addEvent(*newEvent, *coll))
-                success = false;
+            newev->setSummary(QString());   // KAlarm only uses summary for template names
         }
 
+        // Give the event a new ID if required
+        newev->setUid(uid.isEmpty() ? CalEvent::uid(CalFormat::createUniqueId(), type) : uid);
+        newEvents += KAEvent(newev);
+        newEventCollections += coll;
+    }
+
+    // Add the events to the calendars, one batch per collection.
+    Collection* colls[3] = { &activeColl, &archiveColl, &templateColl };
+    const int collCount = (collection && collection->isValid()) ? 1 : 3;
+    if (collCount == 1)
+        colls[0] = collection;
+    for (int c = 0;  c < collCount;  ++c)
+    {
+        KAEvent::List batch;
+        for (int i = 0, end = newEvents.count();  i < end;  ++i)
+            if (newEventCollections[i] == colls[c])
+                batch += &newEvents[i];
+        if (batch.isEmpty())
+            continue;
+        if (!AkonadiModel::instance()->addEvents(batch, *colls[c]))
+            success = false;
+        else if (imported)
+            *imported += batch.count();
     }
-    if (!local)
-        QFile::remove(filename);
     return success;
 }
 
@@ -985,6 +1062,37 @@ bool AlarmCalendar::addEvent(KAEvent& evnt, QWidget* promptParent, bool useEvent
     return true;
 }
 
+/******************************************************************************
+* Add a list of new active events to a resource calendar, all within a single
+* Akonadi transaction. Each event is given a new event ID.
+* 'events' are updated with their actual event IDs and Akonadi item IDs.
+* Reply = true if all the events were scheduled to be written to the calendar.
+*/
+bool AlarmCalendar::addEvents(QVector<KAEvent>& events, Collection& collection)
+{
+    if (!mOpen  ||  mCalType != RESOURCES  ||  !collection.isValid())
+        return false;
+    qCDebug(KALARM_LOG) << events.count();
+    KAEvent::List list;
+    list.reserve(events.count());
+    for (int i = 0, end = events.count();  i < end;  ++i)
+    {
+        KAEvent& event = events[i];
+        if (event.category() != CalEvent::ACTIVE)
+            return false;
+        event.setEventId(CalFormat::createUniqueId());
+        list += &event;
+    }
+    // The events are added to mEventMap once they are inserted into AkonadiModel.
+    if (!AkonadiModel::instance()->addEvents(list, collection))
+        return false;
+    for (int i = 0, end = events.count();  i < end;  ++i)
+    {
+        if (!events[i].enabled())
+            checkForDisabledAlarms(true, false);
+    }
+    return true;
+}
 
 /******************************************************************************
 * Internal method to add an already checked event to the calendar.
@@ -1387,6 +1495,20 @@ bool AlarmCalendar::eventReadOnly(Item::Id id) const
     //   ||  compatibility(event) != KACalendar::Current;
 }
 
+/******************************************************************************
+* Return whether an event held in this calendar is read-only.
+* This avoids the need to fetch the event from the Akonadi model.
+*/
+bool AlarmCalendar::eventReadOnly(const KAEvent& event) const
+{
+    if (mCalType != RESOURCES)
+        return true;
+    const Collection collection = AkonadiModel::instance()->collectionById(event.collectionId());
+    if (!CollectionControlModel::isWritableEnabled(collection, event.category()))
+        return true;
+    return !event.isValid()  ||  event.isReadOnly();
+}
+
 /******************************************************************************
 * Return the collection containing a specified event.
 */
@@ -69,8 +69,10 @@ class AlarmCalendar : public QObject
         KAEvent::List         events(const Akonadi::Collection&, CalEvent::Types = CalEvent::EMPTY) const;
         KCalCore::Event::List kcalEvents(CalEvent::Type s = CalEvent::EMPTY);   // display calendar only
         bool                  eventReadOnly(Akonadi::Item::Id) const;
+        bool                  eventReadOnly(const KAEvent&) const;
         Akonadi::Collection   collectionForEvent(Akonadi::Item::Id) const;
         bool                  addEvent(KAEvent&, QWidget* promptparent = nullptr, bool useEventID = false, Akonadi::Collection* = nullptr, bool noPrompt = false, bool* cancelled = nullptr);
+        bool                  addEvents(QVector<KAEvent>&, Akonadi::Collection&);
         bool                  modifyEvent(const EventId& oldEventId, KAEvent& newEvent);
         KAEvent*              updateEvent(const KAEvent&);
         KAEvent*              updateEvent(const KAEvent*);
@@ -89,6 +91,10 @@ class AlarmCalendar : public QObject
         static AlarmCalendar* displayCalendarOpen();
         static KAEvent*       getEvent(const EventId&);
         static bool           importAlarms(QWidget*, Akonadi::Collection* = nullptr);
+        static bool           importCalendar(const KCalCore::FileStorage::Ptr&, Akonadi::Collection* = nullptr,
+                                             bool skipExisting = false, int* skipped = nullptr, int* imported = nullptr);
+        static bool           importEvents(const KCalCore::Event::List&, KACalendar::Compat, Akonadi::Collection* = nullptr,
+                                           bool skipExisting = false, int* skipped = nullptr, int* imported = nullptr);
         static bool           exportAlarms(const KAEvent::List&, QWidget* parent);
 
     Q_SIGNALS:
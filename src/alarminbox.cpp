@@ -0,0 +1,622 @@
+/*
+ *  alarminbox.cpp  -  single window listing displayed alarms
+ *  Program:  kalarm
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "config-kalarm.h"
+#include "kalarm.h"
+#include "alarminbox_p.h"
+#include "alarminbox.h"
+
+#include "akonadimodel.h"
+#include "alarmcalendar.h"
+#include "alarmtime.h"
+#include "autoqpointer.h"
+#include "deferdlg.h"
+#include "functions.h"
+#include "kalarmapp.h"
+#include "messagebox.h"
+#include "messagewin_p.h"
+#include "messagewin.h"
+#include "preferences.h"
+
+#include <kalarmcal/alarmtext.h>
+
+#include <KLocalizedString>
+#include <kstandardguiitem.h>
+#include <knotification.h>
+
+#include <QApplication>
+#include <QCloseEvent>
+#include <QHBoxLayout>
+#include <QItemSelectionModel>
+#include <QListView>
+#include <QPushButton>
+#include <QTimer>
+#include <QVBoxLayout>
+#include "kalarm_debug.h"
+
+#include <algorithm>
+
+using namespace KAlarmCal;
+
+
+AlarmInbox* AlarmInbox::mInstance = nullptr;
+
+/******************************************************************************
+* Check whether a display alarm should be shown in the alarm inbox rather than
+* in its own message window. This is the case once the number of message
+* windows has reached the configured threshold, and thereafter until the inbox
+* is emptied.
+* Command output alarms are always shown in message windows.
+*/
+bool AlarmInbox::wanted(const KAAlarm& alarm)
+{
+    if (alarm.action() == KAAlarm::COMMAND)
+        return false;
+    const int threshold = Preferences::alarmInboxThreshold();
+    if (threshold <= 0)
+        return false;
+    return count() > 0  ||  MessageWin::instanceCount(true) >= threshold;
+}
+
+/******************************************************************************
+* Return whether the inbox contains an alarm for a specified event.
+*/
+bool AlarmInbox::contains(const EventId& eventId)
+{
+    return mInstance  &&  mInstance->mModel->findEvent(eventId) >= 0;
+}
+
+/******************************************************************************
+* Return the number of alarms in the inbox.
+*/
+int AlarmInbox::count()
+{
+    return mInstance ? mInstance->mModel->rowCount() : 0;
+}
+
+/******************************************************************************
+* Return the unique inbox window, optionally creating it.
+*/
+AlarmInbox* AlarmInbox::instance(bool create)
+{
+    if (!mInstance  &&  create)
+        mInstance = new AlarmInbox;
+    return mInstance;
+}
+
+/******************************************************************************
+* Add a display alarm to the inbox, or update its existing entry, and show the
+* inbox. This performs the same actions as a message window does when it is
+* displayed: the alarm is copied to the displaying calendar, rescheduled if
+* required, and its audio output is played.
+* If 'redisplay' is true, the alarm is being restored from the displaying
+* calendar, so it is not copied there again.
+* The displaying calendar is saved once control returns to the event loop, so
+* that adding a large number of alarms only saves it once.
+*/
+void AlarmInbox::addAlarm(KAEvent& event, const KAAlarm& alarm, int flags, bool redisplay)
+{
+    AlarmInbox* inbox = instance(true);
+    const EventId eventId(event);
+    qCDebug(KALARM_LOG) << eventId << "," << KAAlarm::debugType(alarm.type());
+
+    AlarmInboxModel::Entry entry;
+    const bool reminder = (alarm.type() & KAAlarm::REMINDER_ALARM);
+    if (reminder)
+    {
+        if (event.reminderMinutes() < 0)
+        {
+            event.previousOccurrence(alarm.dateTime(false).effectiveKDateTime(), entry.dateTime, false);
+            if (!entry.dateTime.isValid()  &&  event.repeatAtLogin())
+                entry.dateTime = alarm.dateTime().addSecs(event.reminderMinutes() * 60);
+        }
+        else
+            entry.dateTime = event.mainDateTime(true);
+    }
+    else
+        entry.dateTime = alarm.dateTime(true);
+    const bool readonly = AlarmCalendar::resources()->eventReadOnly(event.itemId());
+    const DateTime limit = event.deferralLimit();
+    entry.event        = event;
+    entry.eventId      = eventId;
+    entry.alarmType    = alarm.type();
+    entry.text         = reminder ? i18nc("@info", "Reminder: %1", AlarmText::summary(event, 1))
+                                  : AlarmText::summary(event, 1);
+    entry.deferLimit   = limit.isValid() ? limit.effectiveKDateTime().toUtc().dateTime() : QDateTime();
+    entry.noDefer      = readonly || (flags & MessageWin::NO_DEFER) || alarm.repeatAtLogin();
+    entry.noPostAction = reminder;
+    entry.audioPending = !event.audioFile().isEmpty()  &&  (event.soundVolume() || event.fadeVolume() > 0);
+
+    AlarmInboxModel* model = inbox->mModel;
+    int row = model->findEvent(eventId);
+    if (row >= 0)
+    {
+        // The alarm is already in the inbox (e.g. its reminder is being
+        // replaced by the main alarm), so update its entry.
+        model->entry(row) = entry;
+        model->updateEntry(row);
+    }
+    else
+    {
+        model->addEntry(entry);
+        row = model->rowCount() - 1;
+    }
+
+    // Copy the alarm to the displaying calendar in case of a crash, etc.
+    AlarmCalendar* cal = redisplay ? nullptr : AlarmCalendar::displayCalendarOpen();
+    if (cal)
+    {
+        KAEvent dispEvent;
+        const Akonadi::Collection collection = AkonadiModel::instance()->collectionForItem(event.itemId());
+        dispEvent.setDisplaying(event, alarm.type(), collection.id(),
+                                entry.dateTime.effectiveKDateTime(), !readonly, !entry.noDefer);
+        cal->deleteDisplayEvent(dispEvent.id());   // in case it already exists
+        cal->addEvent(dispEvent);
+        if (!inbox->mSavePending)
+        {
+            inbox->mSavePending = true;
+            QTimer::singleShot(0, inbox, &AlarmInbox::saveDisplayCalendar);
+        }
+    }
+
+    if (!(flags & MessageWin::NO_RESCHEDULE))
+    {
+        KAEvent& ev = model->entry(row).event;
+        const KAAlarm alm = ev.alarm(alarm.type());
+        if (alm.isValid())
+            theApp()->rescheduleAlarm(ev, alm);
+    }
+
+    if (event.beep())
+    {
+        // Beep using two methods, in case the sound card/speakers are switched off or not working
+        QApplication::beep();      // beep through the internal speaker
+        KNotification::beep();     // beep through the sound card & speakers
+    }
+    if (entry.audioPending)
+        inbox->playNextAudio();
+    else if (event.speak())
+        SpeechQueue::instance()->say(event.cleanText());
+
+    inbox->setWindowTitle(i18ncp("@title:window", "1 Alarm", "%1 Alarms", model->rowCount()));
+    inbox->slotSelectionChanged();
+    if (!inbox->isVisible())
+        inbox->show();
+}
+
+/******************************************************************************
+* Construct the inbox window.
+*/
+AlarmInbox::AlarmInbox()
+    : MainWindowBase(nullptr, Qt::Window | Qt::WindowStaysOnTopHint),
+      mModel(new AlarmInboxModel(this)),
+      mSavePending(false)
+{
+    qCDebug(KALARM_LOG);
+    setObjectName(QStringLiteral("AlarmInbox"));
+    QWidget* topWidget = new QWidget(this);
+    setCentralWidget(topWidget);
+    QVBoxLayout* topLayout = new QVBoxLayout(topWidget);
+
+    mListView = new QListView(topWidget);
+    mListView->setModel(mModel);
+    mListView->setUniformItemSizes(true);   // avoid measuring every entry
+    mListView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    mListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    mListView->setWhatsThis(i18nc("@info:whatsthis", "List of alarms which have triggered and have not yet been acknowledged"));
+    connect(mListView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &AlarmInbox::slotSelectionChanged);
+    topLayout->addWidget(mListView);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    topLayout->addLayout(buttonLayout);
+    mAcknowledgeButton = new QPushButton(i18nc("@action:button", "Acknowledge"), topWidget);
+    mAcknowledgeButton->setWhatsThis(i18nc("@info:whatsthis", "Acknowledge the selected alarms"));
+    connect(mAcknowledgeButton, &QAbstractButton::clicked, this, &AlarmInbox::slotAcknowledge);
+    buttonLayout->addWidget(mAcknowledgeButton);
+
+    mAcknowledgeAllButton = new QPushButton(i18nc("@action:button", "Acknowledge All"), topWidget);
+    mAcknowledgeAllButton->setWhatsThis(i18nc("@info:whatsthis", "Acknowledge all the alarms in the list"));
+    connect(mAcknowledgeAllButton, &QAbstractButton::clicked, this, &AlarmInbox::slotAcknowledgeAll);
+    buttonLayout->addWidget(mAcknowledgeAllButton);
+
+    mDeferButton = new QPushButton(i18nc("@action:button", "Defer..."), topWidget);
+    mDeferButton->setWhatsThis(i18nc("@info:whatsthis", "Defer the selected alarms until later"));
+    connect(mDeferButton, &QAbstractButton::clicked, this, &AlarmInbox::slotDefer);
+    buttonLayout->addWidget(mDeferButton);
+    buttonLayout->addStretch();
+
+    QPushButton* kalarmButton = new QPushButton(QIcon::fromTheme(QStringLiteral("kalarm")), QString(), topWidget);
+    kalarmButton->setToolTip(xi18nc("@info:tooltip", "Activate <application>KAlarm</application>"));
+    connect(kalarmButton, &QAbstractButton::clicked, this, &AlarmInbox::slotShowMainWindow);
+    buttonLayout->addWidget(kalarmButton);
+
+    setAutoSaveSettings(QStringLiteral("AlarmInbox"));
+    slotSelectionChanged();
+}
+
+AlarmInbox::~AlarmInbox()
+{
+    if (mInstance == this)
+        mInstance = nullptr;
+}
+
+/******************************************************************************
+* Called when the window is closed. Closing the window acknowledges all the
+* alarms in it, after confirmation.
+*/
+void AlarmInbox::closeEvent(QCloseEvent* ce)
+{
+    if (!qApp->isSavingSession()  &&  mModel->rowCount())
+    {
+        QList<int> rows;
+        for (int row = 0, end = mModel->rowCount();  row < end;  ++row)
+            rows += row;
+        if (!acknowledge(rows))
+        {
+            ce->ignore();
+            return;
+        }
+    }
+    MainWindowBase::closeEvent(ce);
+}
+
+/******************************************************************************
+* Called when the list selection changes, to enable or disable the buttons.
+* Deferral is only allowed if it is permitted for all the selected alarms.
+*/
+void AlarmInbox::slotSelectionChanged()
+{
+    const QList<int> rows = selectedRows();
+    bool defer = !rows.isEmpty();
+    const QDateTime now = KDateTime::currentUtcDateTime().dateTime();
+    for (int i = 0, end = rows.count();  defer && i < end;  ++i)
+    {
+        const AlarmInboxModel::Entry& entry = mModel->entry(rows[i]);
+        if (entry.noDefer  ||  (entry.deferLimit.isValid()  &&  entry.deferLimit <= now))
+            defer = false;
+    }
+    mAcknowledgeButton->setEnabled(!rows.isEmpty());
+    mAcknowledgeAllButton->setEnabled(mModel->rowCount());
+    mDeferButton->setEnabled(defer);
+}
+
+/******************************************************************************
+* Return the selected rows, in ascending order.
+*/
+QList<int> AlarmInbox::selectedRows() const
+{
+    QList<int> rows;
+    const QModelIndexList indexes = mListView->selectionModel()->selectedRows();
+    for (int i = 0, end = indexes.count();  i < end;  ++i)
+        rows += indexes[i].row();
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+/******************************************************************************
+* Called when the Acknowledge button is clicked.
+*/
+void AlarmInbox::slotAcknowledge()
+{
+    acknowledge(selectedRows());
+}
+
+/******************************************************************************
+* Called when the Acknowledge All button is clicked.
+*/
+void AlarmInbox::slotAcknowledgeAll()
+{
+    close();
+}
+
+/******************************************************************************
+* Save the displaying calendar after alarms have been added to it.
+*/
+void AlarmInbox::saveDisplayCalendar()
+{
+    mSavePending = false;
+    AlarmCalendar* cal = AlarmCalendar::displayCalendarOpen();
+    if (cal)
+        cal->save();
+}
+
+/******************************************************************************
+* Acknowledge the alarms in the specified rows, after confirmation if any of
+* them require it and 'confirm' is true. The alarms are removed from the
+* displaying calendar, and their post-alarm actions are executed.
+* Reply = false if the user cancelled.
+*/
+bool AlarmInbox::acknowledge(const QList<int>& rows, bool confirm)
+{
+    if (rows.isEmpty())
+        return false;
+    for (int i = 0, end = rows.count();  confirm && i < end;  ++i)
+    {
+        if (mModel->entry(rows[i]).event.confirmAck())
+        {
+            // Ask for confirmation of acknowledgement. Use warningYesNo() because its default is No.
+            if (KAMessageBox::warningYesNo(this, i18ncp("@info", "Do you really want to acknowledge this alarm?",
+                                                                 "Do you really want to acknowledge these %1 alarms?", rows.count()),
+                                                 i18nc("@action:button", "Acknowledge Alarm"), KGuiItem(i18nc("@action:button", "Acknowledge")), KStandardGuiItem::cancel())
+                != KMessageBox::Yes)
+                return false;
+            break;
+        }
+    }
+
+    QVector<KAEvent> events;
+    AlarmCalendar* cal = AlarmCalendar::displayCalendarOpen();
+    bool save = false;
+    for (int i = 0, end = rows.count();  i < end;  ++i)
+    {
+        const AlarmInboxModel::Entry& entry = mModel->entry(rows[i]);
+        if (cal  &&  !entry.eventId.isEmpty()
+        &&  cal->deleteDisplayEvent(CalEvent::uid(entry.eventId.eventId(), CalEvent::DISPLAYING)))
+            save = true;
+        if (!entry.noPostAction  &&  !entry.event.postAction().isEmpty())
+            events += entry.event;
+    }
+    if (save)
+        cal->save();    // save the displaying calendar once for all the alarms
+    mModel->removeEntries(rows);
+    for (int i = 0, end = events.count();  i < end;  ++i)
+        theApp()->alarmCompleted(events[i]);
+
+    setWindowTitle(i18ncp("@title:window", "1 Alarm", "%1 Alarms", mModel->rowCount()));
+    slotSelectionChanged();
+    if (!mModel->rowCount())
+    {
+        hide();
+        if (!MessageWin::instanceCount(true))
+            theApp()->quitIf();   // no visible windows remain - check whether to quit
+    }
+    return true;
+}
+
+/******************************************************************************
+* Called when the Defer... button is clicked.
+* Displays the defer dialog, and defers all the selected alarms.
+*/
+void AlarmInbox::slotDefer()
+{
+    const QList<int> rows = selectedRows();
+    if (rows.isEmpty())
+        return;
+    bool dateOnly = true;
+    DateTime limit;
+    for (int i = 0, end = rows.count();  i < end;  ++i)
+    {
+        const AlarmInboxModel::Entry& entry = mModel->entry(rows[i]);
+        if (!entry.dateTime.isDateOnly())
+            dateOnly = false;
+        const DateTime dt = entry.event.deferralLimit();
+        if (dt.isValid()  &&  (!limit.isValid()  ||  dt < limit))
+            limit = dt;
+    }
+    const int defaultMinutes = (rows.count() == 1) ? mModel->entry(rows[0]).event.deferDefaultMinutes() : 0;
+
+    AutoQPointer<DeferAlarmDlg> dlg = new DeferAlarmDlg(KDateTime::currentDateTime(Preferences::timeZone()).addSecs(60), dateOnly, false, this);
+    dlg->setObjectName(QStringLiteral("DeferDlg"));    // used by LikeBack
+    dlg->setDeferMinutes(defaultMinutes > 0 ? defaultMinutes : Preferences::defaultDeferTime());
+    if (limit.isValid())
+        dlg->setLimit(limit);
+    if (dlg->exec() != QDialog::Accepted  ||  !dlg)
+        return;
+    const DateTime dateTime  = dlg->getDateTime();
+    const int      delayMins = dlg->deferMinutes();
+
+    QList<int> deferred;
+    int notFound = 0;
+    for (int i = 0, end = rows.count();  i < end;  ++i)
+    {
+        AlarmInboxModel::Entry& entry = mModel->entry(rows[i]);
+        // Fetch the up-to-date alarm from the calendar. Note that it could have
+        // changed since it was displayed.
+        const KAEvent* event = entry.eventId.isEmpty() ? nullptr : AlarmCalendar::resources()->event(entry.eventId);
+        if (!event)
+        {
+            ++notFound;
+            continue;
+        }
+        qCDebug(KALARM_LOG) << "Deferring event" << entry.eventId;
+        KAEvent newev(*event);
+        newev.defer(dateTime, (entry.alarmType & KAAlarm::REMINDER_ALARM), true);
+        newev.setDeferDefaultMinutes(delayMins);
+        KAlarm::updateEvent(newev, dlg, true);
+        if (newev.deferred())
+            entry.noPostAction = true;
+        deferred += rows[i];
+    }
+    if (theApp()->wantShowInSystemTray())
+    {
+        // Alarms are to be displayed only if the system tray icon is running,
+        // so start it if necessary so that the deferred alarms will be shown.
+        theApp()->displayTrayIcon(true);
+    }
+    acknowledge(deferred, false);   // remove without confirmation prompt
+    if (notFound)
+        KAMessageBox::error(this, xi18ncp("@info", "<para>Cannot defer alarm:</para><para>Alarm not found.</para>",
+                                                   "<para>Cannot defer %1 alarms:</para><para>Alarms not found.</para>", notFound));
+}
+
+/******************************************************************************
+* Called when the KAlarm button is clicked.
+* Displays the main window, with the current alarm selected.
+*/
+void AlarmInbox::slotShowMainWindow()
+{
+    const QModelIndex current = mListView->currentIndex();
+    KAlarm::displayMainWindowSelected(current.isValid() ? mModel->entry(current.row()).event.itemId() : -1);
+}
+
+/******************************************************************************
+* Play the sound file for the most recently added alarm whose sound has not yet
+* been played, provided that the inbox is not already playing one and the
+* limit on concurrent sounds has not been reached. Each sound file is played
+* once only, so that a repeating sound cannot hold up the others.
+*/
+void AlarmInbox::playNextAudio()
+{
+    if (mAudioThread  ||  AudioThread::mInstances.count() >= Preferences::maxConcurrentSounds())
+        return;
+    for (int row = mModel->rowCount();  --row >= 0;  )
+    {
+        if (mModel->entry(row).audioPending)
+        {
+            playAudio(row);
+            return;
+        }
+    }
+}
+
+/******************************************************************************
+* Start playing the sound file for the alarm in the specified row.
+*/
+void AlarmInbox::playAudio(int row)
+{
+    AlarmInboxModel::Entry& entry = mModel->entry(row);
+    entry.audioPending = false;
+    const KAEvent& event = entry.event;
+    qCDebug(KALARM_LOG) << entry.eventId;
+    mAudioThread = new AudioThread(this, event.audioFile(), event.soundVolume(), event.fadeVolume(),
+                                   qMin(event.fadeSeconds(), 86400), -1);
+    connect(mAudioThread.data(), &QThread::finished, this, &AlarmInbox::playFinished);
+    theApp()->notifyAudioPlaying(true);
+    mAudioThread->start();
+}
+
+/******************************************************************************
+* Called when the audio file thread finishes.
+* The next pending sound file is played once the thread has been deleted.
+*/
+void AlarmInbox::playFinished()
+{
+    if (mAudioThread)
+    {
+        const QString errmsg = mAudioThread->error();
+        if (!errmsg.isEmpty())
+            qCWarning(KALARM_LOG) << errmsg;
+    }
+    delete mAudioThread.data();
+}
+
+/******************************************************************************
+* Play any pending sound files. Called when an audio thread has finished.
+*/
+void AlarmInbox::playPendingAudio()
+{
+    if (mInstance)
+        mInstance->playNextAudio();
+}
+
+/******************************************************************************
+* Discard all pending sound files, when audio playback has been stopped.
+*/
+void AlarmInbox::clearPendingAudio()
+{
+    if (mInstance)
+    {
+        for (int row = 0, end = mInstance->mModel->rowCount();  row < end;  ++row)
+            mInstance->mModel->entry(row).audioPending = false;
+    }
+}
+
+
+/*=============================================================================
+= Class: AlarmInboxModel
+=============================================================================*/
+
+int AlarmInboxModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : mEntries.count();
+}
+
+QVariant AlarmInboxModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid()  ||  index.row() >= mEntries.count())
+        return QVariant();
+    const Entry& entry = mEntries[index.row()];
+    switch (role)
+    {
+        case Qt::DisplayRole:
+            if (entry.dateTime.isValid())
+                return QStringLiteral("%1  %2").arg(AlarmTime::alarmTimeText(entry.dateTime), entry.text);
+            return entry.text;
+        case Qt::ToolTipRole:
+            return AlarmText::summary(entry.event, 10);
+        case Qt::BackgroundRole:
+            return entry.event.bgColour();
+        case Qt::ForegroundRole:
+            return entry.event.fgColour();
+        default:
+            return QVariant();
+    }
+}
+
+/******************************************************************************
+* Return the row containing the alarm for a specified event, or -1 if none.
+*/
+int AlarmInboxModel::findEvent(const EventId& eventId) const
+{
+    for (int row = 0, end = mEntries.count();  row < end;  ++row)
+    {
+        if (mEntries[row].eventId == eventId)
+            return row;
+    }
+    return -1;
+}
+
+void AlarmInboxModel::addEntry(const Entry& entry)
+{
+    const int row = mEntries.count();
+    beginInsertRows(QModelIndex(), row, row);
+    mEntries.append(entry);
+    endInsertRows();
+}
+
+void AlarmInboxModel::updateEntry(int row)
+{
+    const QModelIndex ix = index(row, 0);
+    Q_EMIT dataChanged(ix, ix);
+}
+
+/******************************************************************************
+* Remove the entries in the specified rows.
+* Consecutive rows are removed together.
+*/
+void AlarmInboxModel::removeEntries(QList<int> rows)
+{
+    std::sort(rows.begin(), rows.end());
+    int i = rows.count() - 1;
+    while (i >= 0)
+    {
+        const int last = rows[i];
+        int first = last;
+        while (--i >= 0  &&  rows[i] == first - 1)
+            first = rows[i];
+        beginRemoveRows(QModelIndex(), first, last);
+        mEntries.remove(first, last - first + 1);
+        endRemoveRows();
+    }
+}
+
+#include "moc_alarminbox_p.cpp"
+#include "moc_alarminbox.cpp"
+
+// vim: et sw=4:
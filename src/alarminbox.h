@@ -0,0 +1,94 @@
+/*
+ *  alarminbox.h  -  single window listing displayed alarms
+ *  Program:  kalarm
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef ALARMINBOX_H
+#define ALARMINBOX_H
+
+/** @file alarminbox.h - single window listing displayed alarms */
+
+#include "eventid.h"
+#include "mainwindowbase.h"
+
+#include <kalarmcal/kaevent.h>
+
+#include <QPointer>
+
+class QCloseEvent;
+class QListView;
+class QPushButton;
+class AlarmInboxModel;
+class AudioThread;
+
+using namespace KAlarmCal;
+
+/**
+ *  The AlarmInbox class is a single window which lists display alarms, as an
+ *  alternative to showing a separate message window for each alarm. It is used
+ *  once the number of message windows reaches the configured threshold, so
+ *  that a large number of simultaneous alarms (e.g. after the system has been
+ *  suspended) does not create a large number of top level windows.
+ *
+ *  Each alarm is held as a lightweight record in a list model, and only the
+ *  visible entries are rendered. Alarms may be acknowledged or deferred in bulk.
+ */
+class AlarmInbox : public MainWindowBase
+{
+        Q_OBJECT
+    public:
+        ~AlarmInbox();
+        static bool        wanted(const KAAlarm&);
+        static bool        contains(const EventId&);
+        static void        addAlarm(KAEvent&, const KAAlarm&, int flags, bool redisplay = false);
+        static int         count();
+        static void        playPendingAudio();
+        static void        clearPendingAudio();
+
+    protected:
+        void               closeEvent(QCloseEvent*) override;
+
+    private Q_SLOTS:
+        void               slotSelectionChanged();
+        void               slotAcknowledge();
+        void               slotAcknowledgeAll();
+        void               slotDefer();
+        void               slotShowMainWindow();
+        void               playFinished();
+        void               saveDisplayCalendar();
+
+    private:
+        AlarmInbox();
+        static AlarmInbox* instance(bool create);
+        bool               acknowledge(const QList<int>& rows, bool confirm = true);
+        QList<int>         selectedRows() const;
+        void               playAudio(int row);
+        void               playNextAudio();
+
+        static AlarmInbox*  mInstance;      // the unique instance
+        AlarmInboxModel*    mModel;
+        QListView*          mListView;
+        QPushButton*        mAcknowledgeButton;
+        QPushButton*        mAcknowledgeAllButton;
+        QPushButton*        mDeferButton;
+        QPointer<AudioThread> mAudioThread; // thread playing the current sound file
+        bool                mSavePending;   // the displaying calendar is due to be saved
+};
+
+#endif // ALARMINBOX_H
+
+// vim: et sw=4:
@@ -0,0 +1,70 @@
+/*
+ *  alarminbox_p.h  -  private declarations for AlarmInbox
+ *  Program:  kalarm
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef ALARMINBOX_P_H
+#define ALARMINBOX_P_H
+
+#include "eventid.h"
+
+#include <kalarmcal/kaevent.h>
+
+#include <QAbstractListModel>
+#include <QDateTime>
+#include <QVector>
+
+using namespace KAlarmCal;
+
+/*=============================================================================
+= Class: AlarmInboxModel
+= List model holding a lightweight record for each alarm in the alarm inbox.
+=============================================================================*/
+class AlarmInboxModel : public QAbstractListModel
+{
+        Q_OBJECT
+    public:
+        struct Entry
+        {
+            KAEvent       event;          // the whole event, for updating the calendar file
+            EventId       eventId;
+            KAAlarm::Type alarmType;
+            DateTime      dateTime;       // date/time displayed for the alarm
+            QString       text;           // summary text to display
+            QDateTime     deferLimit;     // UTC time at which deferral is no longer allowed, or invalid
+            bool          noDefer;        // deferral is not allowed
+            bool          noPostAction;   // don't execute the post-alarm action on acknowledgement
+            bool          audioPending;   // the sound file is still to be played
+        };
+
+        explicit AlarmInboxModel(QObject* parent = nullptr) : QAbstractListModel(parent) {}
+        int          rowCount(const QModelIndex& parent = QModelIndex()) const override;
+        QVariant     data(const QModelIndex&, int role = Qt::DisplayRole) const override;
+        int          findEvent(const EventId&) const;
+        const Entry& entry(int row) const    { return mEntries[row]; }
+        Entry&       entry(int row)          { return mEntries[row]; }
+        void         addEntry(const Entry&);
+        void         updateEntry(int row);
+        void         removeEntries(QList<int> rows);
+
+    private:
+        QVector<Entry> mEntries;
+};
+
+#endif // ALARMINBOX_P_H
+
+// vim: et sw=4:
@@ -31,6 +31,9 @@
 #include <QApplication>
 #include "kalarm_debug.h"
 
+// Maximum number of cached time column text layouts
+static const int MAX_TIME_LAYOUTS = 1000;
+
 
 void AlarmListDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
 {
@@ -48,30 +51,25 @@ void AlarmListDelegate::paint(QPainter* painter, const QStyleOptionViewItem& opt
         {
             case AlarmListModel::TimeColumn:
             {
-                QString str = index.data(Qt::DisplayRole).toString();
                 // Need to pad out spacing to align times without leading zeroes
-                int i = str.indexOf(QStringLiteral(" ~"));    // look for indicator that leading zeroes are omitted
-                if (i >= 0)
+                const TimeLayout& layout = timeLayout(index.data(Qt::DisplayRole).toString(), opt.font, opt.fontMetrics);
+                if (layout.split)
                 {
                     QVariant value;
                     value = index.data(Qt::ForegroundRole);
                     if (value.isValid())
                         opt.palette.setColor(QPalette::Text, value.value<QColor>());
-                    int digitWidth = opt.fontMetrics.width(QLatin1Char('0'));
-                    QString date = str.left(i + 1);
-                    int w = opt.fontMetrics.width(date) + digitWidth;
-                    drawDisplay(painter, opt, opt.rect, date);
+                    drawDisplay(painter, opt, opt.rect, layout.date);
                     QRect rect(opt.rect);
-                    rect.setLeft(rect.left() + w);
-                    drawDisplay(painter, opt, rect, str.mid(i + 2));
+                    rect.setLeft(rect.left() + layout.timeOffset);
+                    drawDisplay(painter, opt, rect, layout.time);
                     return;
                 }
                 break;
             }
             case AlarmListModel::ColourColumn:
             {
-                const KAEvent event = static_cast<const ItemListModel*>(index.model())->event(index);
-                if (event.isValid()  &&  event.commandError() != KAEvent::CMD_NO_ERROR)
+                if (index.data(AkonadiModel::CommandErrorRole).toInt() != KAEvent::CMD_NO_ERROR)
                 {
                     opt.font.setBold(true);
                     opt.font.setStyleHint(QFont::Serif);
@@ -96,19 +94,8 @@ QSize AlarmListDelegate::sizeHint(const QStyleOptionViewItem& option, const QMod
             {
                 int h = option.fontMetrics.lineSpacing();
                 const int textMargin = QApplication::style()->pixelMetric(QStyle::PM_FocusFrameHMargin) + 1;
-                int w = 2 * textMargin;
-                QString str = index.data(Qt::DisplayRole).toString();
-                // Need to pad out spacing to align times without leading zeroes
-                int i = str.indexOf(QStringLiteral(" ~"));    // look for indicator that leading zeroes are omitted
-                if (i >= 0)
-                {
-                    int digitWidth = option.fontMetrics.width(QLatin1Char('0'));
-                    QString date = str.left(i + 1);
-                    w += option.fontMetrics.width(date) + digitWidth + option.fontMetrics.width(str.mid(i + 2));;
-                }
-                else
-                    w += option.fontMetrics.width(str);
-                return QSize(w, h);
+                const TimeLayout& layout = timeLayout(index.data(Qt::DisplayRole).toString(), option.font, option.fontMetrics);
+                return QSize(2 * textMargin + layout.width, h);
             }
             case AlarmListModel::ColourColumn:
             {
@@ -120,6 +107,44 @@ QSize AlarmListDelegate::sizeHint(const QStyleOptionViewItem& option, const QMod
     return QItemDelegate::sizeHint(option, index);
 }
 
+/******************************************************************************
+* Return the layout of a time column text, measuring it if it is not already
+* cached. The cache is cleared if the font changes.
+*/
+const AlarmListDelegate::TimeLayout& AlarmListDelegate::timeLayout(const QString& text, const QFont& font, const QFontMetrics& metrics) const
+{
+    if (font != mTimeLayoutFont)
+    {
+        mTimeLayouts.clear();
+        mTimeLayoutFont = font;
+    }
+    QHash<QString, TimeLayout>::const_iterator it = mTimeLayouts.constFind(text);
+    if (it != mTimeLayouts.constEnd())
+        return it.value();
+
+    if (mTimeLayouts.count() >= MAX_TIME_LAYOUTS)
+        mTimeLayouts.clear();
+    TimeLayout layout;
+    const int i = text.indexOf(QStringLiteral(" ~"));    // look for indicator that leading zeroes are omitted
+    if (i >= 0)
+    {
+        const int digitWidth = metrics.width(QLatin1Char('0'));
+        layout.date = text.left(i + 1);
+        layout.time = text.mid(i + 2);
+        layout.timeOffset = metrics.width(layout.date) + digitWidth;
+        layout.width = layout.timeOffset + metrics.width(layout.time);
+        layout.split = true;
+    }
+    else
+    {
+        layout.date = text;
+        layout.timeOffset = 0;
+        layout.width = metrics.width(text);
+        layout.split = false;
+    }
+    return mTimeLayouts.insert(text, layout).value();
+}
+
 void AlarmListDelegate::edit(KAEvent* event, EventListView* view)
 {
     KAlarm::editAlarm(event, static_cast<AlarmListView*>(view));   // edit alarm (view-only mode if archived or read-only)
@@ -25,6 +25,9 @@
 
 #include "alarmlistview.h"
 
+#include <QFont>
+#include <QHash>
+
 
 class AlarmListDelegate : public EventListDelegate
 {
@@ -35,6 +38,21 @@ class AlarmListDelegate : public EventListDelegate
         void paint(QPainter*, const QStyleOptionViewItem&, const QModelIndex&) const override;
         QSize sizeHint(const QStyleOptionViewItem&, const QModelIndex&) const override;
         void edit(KAEvent*, EventListView*) override;
+
+    private:
+        // Layout of a time text which omits leading zeroes
+        struct TimeLayout
+        {
+            QString date;         // date part of text, or whole text if no split
+            QString time;         // time part of text
+            int     timeOffset;   // x offset of time part
+            int     width;        // total text width
+            bool    split;        // text is split into date and time parts
+        };
+        const TimeLayout& timeLayout(const QString& text, const QFont&, const QFontMetrics&) const;
+
+        mutable QHash<QString, TimeLayout> mTimeLayouts;   // cached layouts for time column texts
+        mutable QFont                      mTimeLayoutFont; // font used for mTimeLayouts
 };
 
 #endif
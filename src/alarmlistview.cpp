@@ -26,35 +26,163 @@
 
 #include <QHeaderView>
 #include <QApplication>
+#include <QTimer>
 
+namespace
+{
+// Columns whose widths are adjusted to fit their contents
+const int autoSizeColumns[] = { AlarmListModel::TimeColumn, AlarmListModel::TimeToColumn, AlarmListModel::RepeatColumn };
+const int FIRST_AUTOSIZE_COLUMN = AlarmListModel::TimeColumn;
+const int LAST_AUTOSIZE_COLUMN  = AlarmListModel::RepeatColumn;
+// Number of rows above which only a sample of rows is measured
+const int MAX_MEASURED_ROWS = 500;
+// Delay before rescanning column widths after rows are removed or reset
+const int RESCAN_DELAY = 200;   // milliseconds
+}
 
 AlarmListView::AlarmListView(const QByteArray& configGroup, QWidget* parent)
     : EventListView(parent),
-      mConfigGroup(configGroup)
+      mConfigGroup(configGroup),
+      mColumnWidths(AlarmListModel::ColumnCount, 0)
 {
     setEditOnSingleClick(true);
     connect(header(), &QHeaderView::sectionMoved, this, &AlarmListView::sectionMoved);
+    mRescanTimer = new QTimer(this);
+    mRescanTimer->setSingleShot(true);
+    mRescanTimer->setInterval(RESCAN_DELAY);
+    connect(mRescanTimer, &QTimer::timeout, this, &AlarmListView::rescanColumnWidths);
 }
 
 void AlarmListView::setModel(QAbstractItemModel* model)
 {
+    if (this->model())
+    {
+        disconnect(this->model(), nullptr, this, nullptr);
+        disconnect(this->model(), nullptr, mRescanTimer, nullptr);
+    }
     EventListView::setModel(model);
+    // Track the widths of the auto-sized columns as the model's contents change.
+    // Using QHeaderView::ResizeToContents would measure every row each time.
+    connect(model, &QAbstractItemModel::rowsInserted, this, &AlarmListView::slotRowsInserted);
+    connect(model, &QAbstractItemModel::dataChanged, this, &AlarmListView::slotDataChanged);
+    connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), mRescanTimer, SLOT(start()));
+    connect(model, SIGNAL(modelReset()), mRescanTimer, SLOT(start()));
+    connect(model, SIGNAL(layoutChanged()), mRescanTimer, SLOT(start()));
     KConfigGroup config(KSharedConfig::openConfig(), mConfigGroup.constData());
     QByteArray settings = config.readEntry("ListHead", QByteArray());
     if (!settings.isEmpty())
         header()->restoreState(settings);
     header()->setMovable(true);
     header()->setStretchLastSection(false);
-    header()->setResizeMode(AlarmListModel::TimeColumn, QHeaderView::ResizeToContents);
-    header()->setResizeMode(AlarmListModel::TimeToColumn, QHeaderView::ResizeToContents);
-    header()->setResizeMode(AlarmListModel::RepeatColumn, QHeaderView::ResizeToContents);
+    header()->setResizeMode(AlarmListModel::TimeColumn, QHeaderView::Fixed);
+    header()->setResizeMode(AlarmListModel::TimeToColumn, QHeaderView::Fixed);
+    header()->setResizeMode(AlarmListModel::RepeatColumn, QHeaderView::Fixed);
     header()->setResizeMode(AlarmListModel::ColourColumn, QHeaderView::Fixed);
     header()->setResizeMode(AlarmListModel::TypeColumn, QHeaderView::Fixed);
     header()->setResizeMode(AlarmListModel::TextColumn, QHeaderView::Stretch);
-    header()->setStretchLastSection(true);   // necessary to ensure ResizeToContents columns do resize to contents!
+    header()->setStretchLastSection(true);
     const int margin = QApplication::style()->pixelMetric(QStyle::PM_FocusFrameHMargin);
     header()->resizeSection(AlarmListModel::ColourColumn, viewOptions().fontMetrics.lineSpacing() * 3 / 4);
     header()->resizeSection(AlarmListModel::TypeColumn, AlarmListModel::iconWidth() + 2*margin + 2);
+    rescanColumnWidths();
+}
+
+/******************************************************************************
+* Called when rows have been inserted into the model.
+* Widen the auto-sized columns if any new row needs more space.
+*/
+void AlarmListView::slotRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (!parent.isValid()
+    &&  measureRows(first, last, FIRST_AUTOSIZE_COLUMN, LAST_AUTOSIZE_COLUMN))
+        applyColumnWidths();
+}
+
+/******************************************************************************
+* Called when data in the model has changed.
+* Widen the auto-sized columns if any changed row needs more space. Columns
+* are only narrowed by a full rescan, which is done when rows are removed.
+*/
+void AlarmListView::slotDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    if (topLeft.parent().isValid()
+    ||  topLeft.column() > LAST_AUTOSIZE_COLUMN  ||  bottomRight.column() < FIRST_AUTOSIZE_COLUMN)
+        return;
+    if (measureRows(topLeft.row(), bottomRight.row(),
+                    qMax(topLeft.column(), FIRST_AUTOSIZE_COLUMN), qMin(bottomRight.column(), LAST_AUTOSIZE_COLUMN)))
+        applyColumnWidths();
+}
+
+/******************************************************************************
+* Recalculate the widths of the auto-sized columns from scratch.
+*/
+void AlarmListView::rescanColumnWidths()
+{
+    mRescanTimer->stop();
+    for (int col : autoSizeColumns)
+        mColumnWidths[col] = 0;
+    if (model())
+        measureRows(0, model()->rowCount() - 1, FIRST_AUTOSIZE_COLUMN, LAST_AUTOSIZE_COLUMN);
+    applyColumnWidths();
+}
+
+/******************************************************************************
+* Measure the contents of the auto-sized columns in a range of rows, and update
+* the maximum column widths. If the range is large, only a sample of rows is
+* measured, together with the rows currently visible.
+* Reply = true if any column width has increased.
+*/
+bool AlarmListView::measureRows(int first, int last, int firstColumn, int lastColumn)
+{
+    const QAbstractItemModel* m = model();
+    if (!m  ||  first > last)
+        return false;
+    const int count = last - first + 1;
+    const int step = (count > MAX_MEASURED_ROWS) ? count / MAX_MEASURED_ROWS : 1;
+    int visibleFirst = -1, visibleLast = -1;
+    if (step > 1)
+    {
+        const QModelIndex top = indexAt(viewport()->rect().topLeft());
+        if (top.isValid())
+        {
+            visibleFirst = top.row();
+            const QModelIndex bottom = indexAt(viewport()->rect().bottomLeft());
+            visibleLast = bottom.isValid() ? bottom.row() : m->rowCount() - 1;
+        }
+    }
+    const QStyleOptionViewItem option = viewOptions();
+    QAbstractItemDelegate* delegate = itemDelegate();
+    bool increased = false;
+    for (int row = first;  row <= last;  ++row)
+    {
+        if (step > 1  &&  (row - first) % step  &&  row != last
+        &&  (row < visibleFirst  ||  row > visibleLast))
+            continue;
+        for (int col = firstColumn;  col <= lastColumn;  ++col)
+        {
+            const int w = delegate->sizeHint(option, m->index(row, col)).width();
+            if (w > mColumnWidths[col])
+            {
+                mColumnWidths[col] = w;
+                increased = true;
+            }
+        }
+    }
+    return increased;
+}
+
+/******************************************************************************
+* Set the widths of the auto-sized columns to fit their contents and headers.
+*/
+void AlarmListView::applyColumnWidths()
+{
+    QHeaderView* head = header();
+    for (int col : autoSizeColumns)
+    {
+        const int w = qMax(mColumnWidths[col], head->sectionSizeHint(col));
+        if (w != head->sectionSize(col))
+            head->resizeSection(col, w);
+    }
 }
 
 /******************************************************************************
@@ -109,15 +237,4 @@ void AlarmListView::selectTimeColumns(bool time, bool timeTo)
 //    }
 }
 
-/*
-void AlarmListView::dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
-{
-    for (int col = topLeft.column();  col < bottomRight.column();  ++col)
-    {
-        if (col != header()->resizeMode(col) == QHeaderView::ResizeToContents)
-            resizeColumnToContents(col);
-    }
-}
-*/
-
 // vim: et sw=4:
@@ -26,6 +26,9 @@
 #include "eventlistview.h"
 
 #include <QByteArray>
+#include <QVector>
+
+class QTimer;
 
 
 class AlarmListView : public EventListView
@@ -38,9 +41,17 @@ class AlarmListView : public EventListView
 
     private Q_SLOTS:
         void        sectionMoved();
+        void        slotRowsInserted(const QModelIndex& parent, int first, int last);
+        void        slotDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+        void        rescanColumnWidths();
 
     private:
-        QByteArray  mConfigGroup;
+        bool        measureRows(int first, int last, int firstColumn, int lastColumn);
+        void        applyColumnWidths();
+
+        QByteArray   mConfigGroup;
+        QVector<int> mColumnWidths;    // maximum content width found for each auto-sized column
+        QTimer*      mRescanTimer;     // delays full rescan of column widths
 };
 
 #endif // ALARMLISTVIEW_H
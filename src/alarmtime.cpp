@@ -31,73 +31,147 @@
 
 using namespace KAlarmCal;
 
-int AlarmTime::mTimeHourPos = -2;
+// Maximum number of entries in each text cache
+static const int MAX_CACHED_TEXTS = 2000;
+
+int                   AlarmTime::mTimeHourPos = -2;
+QLocale               AlarmTime::mCacheLocale;
+QHash<QDate, QString> AlarmTime::mDateTexts;
+QHash<int, QString>   AlarmTime::mTimeTexts;
+QHash<int, QString>   AlarmTime::mTimeToTexts;
+QHash<int, QString>   AlarmTime::mDaysToTexts;
+
+/******************************************************************************
+* Clear the cached texts if the locale has changed since they were formatted.
+* Note that the cache keys are local dates and times which have already been
+* converted to the display time zone, so the texts don't depend on the zone.
+*/
+void AlarmTime::checkLocale()
+{
+    const QLocale locale;
+    if (locale != mCacheLocale)
+    {
+        mCacheLocale = locale;
+        mTimeHourPos = -2;
+        mDateTexts.clear();
+        mTimeTexts.clear();
+        mTimeToTexts.clear();
+        mDaysToTexts.clear();
+    }
+}
 
 /******************************************************************************
 * Return the alarm time text in the form "date time".
+* Date and time of day texts are cached, since many alarms share them.
 */
 QString AlarmTime::alarmTimeText(const DateTime& dateTime)
 {
     if (!dateTime.isValid())
         return i18nc("@info Alarm never occurs", "Never");
-    QLocale locale;
+    checkLocale();
     const KDateTime kdt = dateTime.effectiveKDateTime().toTimeSpec(Preferences::timeZone());
-    QString dateTimeText = locale.toString(kdt.date(), QLocale::ShortFormat);
+    const QDate date = kdt.date();
+    QHash<QDate, QString>::const_iterator it = mDateTexts.constFind(date);
+    if (it == mDateTexts.constEnd())
+    {
+        if (mDateTexts.count() >= MAX_CACHED_TEXTS)
+            mDateTexts.clear();
+        it = mDateTexts.insert(date, mCacheLocale.toString(date, QLocale::ShortFormat));
+    }
+    QString dateTimeText = it.value();
     if (!dateTime.isDateOnly()
     ||  (!dateTime.isClockTime()  &&  kdt.utcOffset() != dateTime.utcOffset()))
     {
         // Display the time of day if it's a date/time value, or if it's
         // a date-only value but it's in a different time zone
         dateTimeText += QLatin1Char(' ');
-        const QString time = locale.toString(kdt.time(), QLocale::ShortFormat);
-        if (mTimeHourPos == -2)
+        dateTimeText += timeText(kdt.time());
+    }
+    return dateTimeText + QLatin1Char(' ');
+}
+
+/******************************************************************************
+* Return the text for a time of day, prefixed by '~' if leading zeroes are
+* omitted. Texts are cached by minute of day.
+*/
+QString AlarmTime::timeText(const QTime& t)
+{
+    const int minute = t.hour() * 60 + t.minute();
+    QHash<int, QString>::const_iterator it = mTimeTexts.constFind(minute);
+    if (it != mTimeTexts.constEnd())
+        return it.value();
+
+    const QLocale& locale = mCacheLocale;
+    const QString time = locale.toString(QTime(t.hour(), t.minute()), QLocale::ShortFormat);
+    if (mTimeHourPos == -2)
+    {
+        // Initialise the position of the hour within the time string, if leading
+        // zeroes are omitted, so that displayed times can be aligned with each other.
+        mTimeHourPos = -1;     // default = alignment isn't possible/sensible
+        if (QApplication::isLeftToRight())    // don't try to align right-to-left languages
         {
-            // Initialise the position of the hour within the time string, if leading
-            // zeroes are omitted, so that displayed times can be aligned with each other.
-            mTimeHourPos = -1;     // default = alignment isn't possible/sensible
-            if (QApplication::isLeftToRight())    // don't try to align right-to-left languages
-            {
-                // Check if leading zeroes are omitted, and whether the hour is first
-                const QString fmt = locale.timeFormat(QLocale::ShortFormat);
-                int i = fmt.indexOf(QRegExp(QLatin1String("[hH]")));
-                int first = fmt.indexOf(QRegExp(QLatin1String("[hHmszaA]")));
-                if (i >= 0  &&  i == first  &&  (i == fmt.size() - 1  ||  fmt[i] != fmt[i + 1]))
-                    mTimeHourPos = i;             // yes, so need to align
-            }
+            // Check if leading zeroes are omitted, and whether the hour is first
+            const QString fmt = locale.timeFormat(QLocale::ShortFormat);
+            int i = fmt.indexOf(QRegExp(QLatin1String("[hH]")));
+            int first = fmt.indexOf(QRegExp(QLatin1String("[hHmszaA]")));
+            if (i >= 0  &&  i == first  &&  (i == fmt.size() - 1  ||  fmt[i] != fmt[i + 1]))
+                mTimeHourPos = i;             // yes, so need to align
         }
-        if (mTimeHourPos >= 0  &&  (int)time.length() > mTimeHourPos + 1
-        &&  time[mTimeHourPos].isDigit()  &&  !time[mTimeHourPos + 1].isDigit())
-            dateTimeText += QLatin1Char('~');     // improve alignment of times with no leading zeroes
-        dateTimeText += time;
     }
-    return dateTimeText + QLatin1Char(' ');
+    QString text;
+    if (mTimeHourPos >= 0  &&  (int)time.length() > mTimeHourPos + 1
+    &&  time[mTimeHourPos].isDigit()  &&  !time[mTimeHourPos + 1].isDigit())
+        text += QLatin1Char('~');     // improve alignment of times with no leading zeroes
+    text += time;
+    if (mTimeTexts.count() >= MAX_CACHED_TEXTS)
+        mTimeTexts.clear();
+    return mTimeTexts.insert(minute, text).value();
 }
 
 /******************************************************************************
 * Return the time-to-alarm text.
+* Texts are cached by the number of minutes or days, since many alarms share
+* them.
 */
 QString AlarmTime::timeToAlarmText(const DateTime& dateTime)
 {
     if (!dateTime.isValid())
         return i18nc("@info Alarm never occurs", "Never");
+    checkLocale();
     KDateTime now = KDateTime::currentUtcDateTime();
     if (dateTime.isDateOnly())
     {
         int days = now.date().daysTo(dateTime.date());
+        QHash<int, QString>::const_iterator it = mDaysToTexts.constFind(days);
+        if (it != mDaysToTexts.constEnd())
+            return it.value();
+        if (mDaysToTexts.count() >= MAX_CACHED_TEXTS)
+            mDaysToTexts.clear();
         // xgettext: no-c-format
-        return i18nc("@info n days", "%1d", days);
+        return mDaysToTexts.insert(days, i18nc("@info n days", "%1d", days)).value();
     }
     int mins = (now.secsTo(dateTime.effectiveKDateTime()) + 59) / 60;
     if (mins < 0)
         return QString();
+    QHash<int, QString>::const_iterator it = mTimeToTexts.constFind(mins);
+    if (it != mTimeToTexts.constEnd())
+        return it.value();
+    if (mTimeToTexts.count() >= MAX_CACHED_TEXTS)
+        mTimeToTexts.clear();
+    const int totalMins = mins;
     char minutes[3] = "00";
     minutes[0] = (mins%60) / 10 + '0';
     minutes[1] = (mins%60) % 10 + '0';
+    QString text;
     if (mins < 24*60)
-        return i18nc("@info hours:minutes", "%1:%2", mins/60, QLatin1String(minutes));
-    int days = mins / (24*60);
-    mins = mins % (24*60);
-    return i18nc("@info days hours:minutes", "%1d %2:%3", days, mins/60, QLatin1String(minutes));
+        text = i18nc("@info hours:minutes", "%1:%2", mins/60, QLatin1String(minutes));
+    else
+    {
+        int days = mins / (24*60);
+        mins = mins % (24*60);
+        text = i18nc("@info days hours:minutes", "%1d %2:%3", days, mins/60, QLatin1String(minutes));
+    }
+    return mTimeToTexts.insert(totalMins, text).value();
 }
 
 /******************************************************************************
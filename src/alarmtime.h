@@ -20,6 +20,9 @@
 
 #include <kdatetime.h>
 
+#include <QHash>
+#include <QLocale>
+
 namespace KAlarmCal { class DateTime; }
 
 class AlarmTime
@@ -33,7 +36,16 @@ class AlarmTime
                                    bool haveTime, const KDateTime& defaultDt = KDateTime());
 
   private:
+    static void checkLocale();
+    static QString timeText(const QTime&);
+
     static int mTimeHourPos;
+    // Caches of formatted texts, which are valid for mCacheLocale
+    static QLocale              mCacheLocale;
+    static QHash<QDate, QString> mDateTexts;      // date texts, keyed by date
+    static QHash<int, QString>  mTimeTexts;       // time of day texts, keyed by minute of day
+    static QHash<int, QString>  mTimeToTexts;     // time-to-alarm texts, keyed by minutes
+    static QHash<int, QString>  mDaysToTexts;     // time-to-alarm texts, keyed by days
 };
 
 // vim: et sw=4:
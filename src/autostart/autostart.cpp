@@ -22,18 +22,31 @@
 #include "autostart.h"
 #include "kalarm_autostart_debug.h"
 
-#include <kcmdlineargs.h>
-#include <K4AboutData>
-#include <KLocalizedString>
-#include <kprocess.h>
-
-#include <QTimer>
-#include <QtDBus/QtDBus>
+#include <QCommandLineParser>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusReply>
+#include <QDBusServiceWatcher>
+#include <QProcess>
 #include <QStandardPaths>
+#include <QTimer>
+
+// Maximum number of seconds to wait for the services which KAlarm depends on
+// to become available, before autostarting KAlarm regardless.
+static const int AUTOSTART_TIMEOUT = 30;
 
-// Number of seconds to wait before autostarting KAlarm.
-// Allow plenty of time for session restoration to happen first.
-static const int AUTOSTART_DELAY = 30;
+// Number of seconds to wait after the required services have all become
+// available, before autostarting KAlarm. The services typically appear before
+// session restoration has restarted KAlarm, so this allows time for that to
+// happen, to avoid the restored instance becoming a second instance.
+static const int SESSION_RESTORE_GRACE = 10;
+
+// D-Bus services which must be registered before KAlarm is started:
+// the Akonadi server, and the session's system tray host.
+static const char* AKONADI_DBUS_SERVICE = "org.freedesktop.Akonadi";
+static const char* TRAY_DBUS_SERVICE    = "org.kde.StatusNotifierWatcher";
 
 #define PROGRAM_VERSION      "1.0"
 #define PROGRAM_NAME "kalarmautostart"
@@ -41,64 +54,139 @@ static const int AUTOSTART_DELAY = 30;
 
 int main(int argc, char *argv[])
 {
-    KLocalizedString::setApplicationDomain("kalarm");
-    K4AboutData aboutData(PROGRAM_NAME, "kalarm", ki18n("KAlarm Autostart"),
-        PROGRAM_VERSION, ki18n("KAlarm autostart at login"), K4AboutData::License_GPL,
-        ki18n("Copyright 2001,2008 David Jarvie"), KLocalizedString(),
-        "http://www.astrojar.org.uk/kalarm");
-    aboutData.addAuthor(ki18n("David Jarvie"), ki18n("Maintainer"), "djarvie@kde.org");
-    aboutData.setOrganizationDomain("kalarm.kde.org");
-    KCmdLineArgs::init(argc, argv, &aboutData);
-
-    KCmdLineOptions options;
-    options.add("!+app", ki18n("Application to autostart"));
-    options.add("+[arg]", ki18n("Command line arguments"));
-    KCmdLineArgs::addCmdLineOptions(options);
-
-    AutostartApp app;
+    AutostartApp app(argc, argv);
     return app.exec();
 }
 
 
 
-AutostartApp::AutostartApp()
-    : KApplication(false)       // initialise as non-GUI application
+/******************************************************************************
+* Construct the application. Rather than waiting for a fixed delay, watch for
+* the services which KAlarm needs to be registered on the session bus, and
+* start KAlarm shortly after they are all present, unless session restoration
+* starts it first.
+*/
+AutostartApp::AutostartApp(int& argc, char** argv)
+    : QCoreApplication(argc, argv)
 {
-    // Disable session management: there is no state to save, and
-    // disabling prevents a crash on logout before this app exits.
-    disableSessionManagement();
+    setApplicationName(QStringLiteral(PROGRAM_NAME));
+    setApplicationVersion(QStringLiteral(PROGRAM_VERSION));
+    setOrganizationDomain(QStringLiteral("kalarm.kde.org"));
+
+    QCommandLineParser parser;
+    parser.addPositionalArgument(QStringLiteral("app"), QStringLiteral("Application to autostart"));
+    parser.addPositionalArgument(QStringLiteral("arg"), QStringLiteral("Command line arguments"), QStringLiteral("[arg...]"));
+    parser.process(*this);
+    mCommandLine = parser.positionalArguments();
 
     // Login session is starting up - need to wait for it to complete
     // in order to avoid starting the client before it is restored by
-    // the session (where applicable).
-    QTimer::singleShot(AUTOSTART_DELAY * 1000, this, &AutostartApp::slotAutostart);
+    // the session (where applicable), or before the services which it
+    // needs are available.
+    mWaitingFor << QLatin1String(AKONADI_DBUS_SERVICE) << QLatin1String(TRAY_DBUS_SERVICE);
+    const QStringList services = QStringList() << QStringLiteral(KALARM_DBUS_SERVICE) << mWaitingFor.toList();
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    mServiceWatcher = new QDBusServiceWatcher(QString(), bus, QDBusServiceWatcher::WatchForRegistration, this);
+    for (const QString& service : services)
+        mServiceWatcher->addWatchedService(service);
+    connect(mServiceWatcher, &QDBusServiceWatcher::serviceRegistered, this, &AutostartApp::slotServiceRegistered);
+
+    // Find which services are already registered. The watcher was set up
+    // first, so that no registration can be missed in the meantime.
+    for (const QString& service : services)
+    {
+        QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(bus.interface()->asyncCall(QStringLiteral("NameHasOwner"), service), this);
+        watcher->setProperty("service", service);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, &AutostartApp::slotServiceChecked);
+    }
+
+    QTimer::singleShot(AUTOSTART_TIMEOUT * 1000, this, &AutostartApp::slotAutostart);
 }
 
+/******************************************************************************
+* Called when the initial check for whether a service is registered completes.
+*/
+void AutostartApp::slotServiceChecked(QDBusPendingCallWatcher* watcher)
+{
+    QDBusPendingReply<bool> reply = *watcher;
+    const QString service = watcher->property("service").toString();
+    watcher->deleteLater();
+    if (reply.isError())
+        qCWarning(KALARMAUTOSTART_LOG) << "Error checking D-Bus service" << service << ":" << reply.error().message();
+    else if (reply.value())
+        slotServiceRegistered(service);
+}
+
+/******************************************************************************
+* Called when a watched service is registered on the session bus.
+*/
+void AutostartApp::slotServiceRegistered(const QString& service)
+{
+    if (mDone)
+        return;
+    if (service == QLatin1String(KALARM_DBUS_SERVICE))
+    {
+        // KAlarm has been started by someone else, e.g. session restoration.
+        qCDebug(KALARMAUTOSTART_LOG) << "KAlarm already running";
+        mDone = true;
+        exit();
+        return;
+    }
+    if (mWaitingFor.remove(service))
+    {
+        qCDebug(KALARMAUTOSTART_LOG) << "Service ready:" << service;
+        checkReady();
+    }
+}
+
+/******************************************************************************
+* If all the services which KAlarm needs are now available, start KAlarm after
+* a grace period to allow session restoration to start it instead.
+*/
+void AutostartApp::checkReady()
+{
+    if (mWaitingFor.isEmpty())
+    {
+        qCDebug(KALARMAUTOSTART_LOG) << "All services ready: waiting for session restoration";
+        QTimer::singleShot(SESSION_RESTORE_GRACE * 1000, this, &AutostartApp::slotAutostart);
+    }
+}
+
+/******************************************************************************
+* Start KAlarm, and then exit.
+* This is called a grace period after all the required services are available,
+* or after a timeout if some of them have not appeared. If KAlarm has been
+* started in the meantime, e.g. by session restoration, its registration will
+* normally have been notified already; but check again in case the
+* notification is still pending.
+*/
 void AutostartApp::slotAutostart()
 {
+    if (mDone)
+        return;
+    mDone = true;
     QDBusReply<bool> reply = QDBusConnection::sessionBus().interface()->isServiceRegistered(QStringLiteral(KALARM_DBUS_SERVICE));
     if (reply.isValid()  &&  reply.value())
+    {
         qCDebug(KALARMAUTOSTART_LOG) << "KAlarm already running";
+        exit();
+        return;
+    }
+    if (!mWaitingFor.isEmpty())
+        qCWarning(KALARMAUTOSTART_LOG) << "Timed out waiting for services:" << mWaitingFor.toList();
+
+    if (mCommandLine.isEmpty())
+        qCWarning(KALARMAUTOSTART_LOG) << "No command line";
     else
     {
-        KCmdLineArgs* args = KCmdLineArgs::parsedArgs();
-        if (args->count() <= 0)
-            qCWarning(KALARMAUTOSTART_LOG) << "No command line";
+        const QString prog = mCommandLine.at(0);
+        const QString exe = QStandardPaths::findExecutable(prog);
+        if (exe.isEmpty())
+            qCWarning(KALARMAUTOSTART_LOG) << "Executable not found:" << prog;
         else
         {
-            const QString prog = args->arg(0);
-            const QString exe = QStandardPaths::findExecutable(prog);
-            if (exe.isEmpty())
-                qCWarning(KALARMAUTOSTART_LOG) << "Executable not found:" << prog;
-            else
-            {
-                qCDebug(KALARMAUTOSTART_LOG) << "Starting" << prog;
-                KProcess proc;
-                proc << exe;
-                for (int i = 1;  i < args->count();  ++i)
-                    proc << args->arg(i);
-                proc.startDetached();
-            }
+            qCDebug(KALARMAUTOSTART_LOG) << "Starting" << prog;
+            QProcess::startDetached(exe, mCommandLine.mid(1));
         }
     }
     exit();
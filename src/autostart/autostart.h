@@ -21,17 +21,32 @@
 #ifndef AUTOSTART_H
 #define AUTOSTART_H
 
-#include <kapplication.h>
+#include <QCoreApplication>
+#include <QSet>
+#include <QStringList>
 
-class AutostartApp : public KApplication
+class QDBusPendingCallWatcher;
+class QDBusServiceWatcher;
+
+class AutostartApp : public QCoreApplication
 {
         Q_OBJECT
     public:
-        AutostartApp();
+        AutostartApp(int& argc, char** argv);
         ~AutostartApp()  {}
 
     private Q_SLOTS:
+        void slotServiceRegistered(const QString& service);
+        void slotServiceChecked(QDBusPendingCallWatcher*);
         void slotAutostart();
+
+    private:
+        void checkReady();
+
+        QDBusServiceWatcher* mServiceWatcher;
+        QStringList          mCommandLine;     // application to start, followed by its arguments
+        QSet<QString>        mWaitingFor;      // D-Bus services not yet registered
+        bool                 mDone {false};    // the application has been started, or need not be
 };
 
 #endif // AUTOSTART_H
@@ -268,10 +268,35 @@ QVector<KAEvent> BirthdayDlg::events() const
     int count = indexes.count();
     if (!count)
         return list;
+    list.reserve(count);
     QDate today = KDateTime::currentLocalDate();
     KDateTime todayStart(today, KDateTime::Spec(KDateTime::ClockTime));
     int thisYear = today.year();
     int reminder = mReminder->minutes();
+
+    // Fetch the settings which are common to all the alarms once only.
+    const QString prefix = mPrefix->text();
+    const QString suffix = mSuffix->text();
+    const QColor  bgColour = mFontColourButton->bgColour();
+    const QColor  fgColour = mFontColourButton->fgColour();
+    const QFont   font = mFontColourButton->font();
+    const int     lateCancel = mLateCancel->minutes();
+    float fadeVolume;
+    int   fadeSecs;
+    const float   volume = mSoundPicker->volume(fadeVolume, fadeSecs);
+    const int     repeatPause = mSoundPicker->repeatPause();
+    const QString audioFile = mSoundPicker->file().toDisplayString();
+    const Repetition repetition = mSubRepetition->repetition();
+    QString preAction, postAction;
+    KAEvent::ExtraActionOptions actionOptions(0);
+    if (mSpecialActionsButton)
+    {
+        preAction     = mSpecialActionsButton->preAction();
+        postAction    = mSpecialActionsButton->postAction();
+        actionOptions = mSpecialActionsButton->options();
+    }
+    const KARecurrence::Feb29Type feb29 = KARecurrence::defaultFeb29Type();
+
     for (int i = 0;  i < count;  ++i)
     {
         const QModelIndex nameIndex = indexes.at(i).model()->index(indexes.at(i).row(), 0);
@@ -282,25 +307,18 @@ QVector<KAEvent> BirthdayDlg::events() const
         if (date <= today)
             date.setYMD(thisYear + 1, date.month(), date.day());
         KAEvent event(KDateTime(date, KDateTime::Spec(KDateTime::ClockTime)),
-                      mPrefix->text() + name + mSuffix->text(),
-                      mFontColourButton->bgColour(), mFontColourButton->fgColour(),
-                      mFontColourButton->font(), KAEvent::MESSAGE, mLateCancel->minutes(),
+                      prefix + name + suffix,
+                      bgColour, fgColour, font, KAEvent::MESSAGE, lateCancel,
                       mFlags, true);
-        float fadeVolume;
-        int   fadeSecs;
-        float volume = mSoundPicker->volume(fadeVolume, fadeSecs);
-        int   repeatPause = mSoundPicker->repeatPause();
-        event.setAudioFile(mSoundPicker->file().toDisplayString(), volume, fadeVolume, fadeSecs, repeatPause);
+        event.setAudioFile(audioFile, volume, fadeVolume, fadeSecs, repeatPause);
         QVector<int> months(1, date.month());
-        event.setRecurAnnualByDate(1, months, 0, KARecurrence::defaultFeb29Type(), -1, QDate());
-        event.setRepetition(mSubRepetition->repetition());
+        event.setRecurAnnualByDate(1, months, 0, feb29, -1, QDate());
+        event.setRepetition(repetition);
         event.setNextOccurrence(todayStart);
         if (reminder)
             event.setReminder(reminder, false);
         if (mSpecialActionsButton)
-            event.setActions(mSpecialActionsButton->preAction(),
-                             mSpecialActionsButton->postAction(),
-                             mSpecialActionsButton->options());
+            event.setActions(preAction, postAction, actionOptions);
         event.endChanges();
         list.append(event);
     }
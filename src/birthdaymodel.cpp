@@ -84,29 +84,109 @@ QVariant BirthdayModel::entityData(const Akonadi::Item& item, int column, int ro
 }
 
 
+/******************************************************************************
+* Constructor.
+* Build an index of the message texts of all existing birthday alarms, which is
+* then kept up to date as alarms are added, changed and removed.
+* The index is independent of the prefix and suffix texts, so it only needs to
+* be built once.
+*/
 BirthdaySortModel::BirthdaySortModel(QObject* parent)
     : QSortFilterProxyModel(parent)
 {
+    const KAEvent::List events = AlarmCalendar::resources()->events(CalEvent::ACTIVE);
+    for (int i = 0, end = events.count();  i < end;  ++i)
+    {
+        const KAEvent* event = events[i];
+        addBirthdayAlarm(EventId(*event), *event);
+    }
+
+    AkonadiModel* model = AkonadiModel::instance();
+    connect(model, &AkonadiModel::eventsAdded, this, &BirthdaySortModel::slotEventsAdded);
+    connect(model, &AkonadiModel::eventsToBeRemoved, this, &BirthdaySortModel::slotEventsToBeRemoved);
+    connect(model, &AkonadiModel::eventChanged, this, &BirthdaySortModel::slotEventChanged);
 }
 
 void BirthdaySortModel::setPrefixSuffix(const QString& prefix, const QString& suffix)
 {
-    mContactsWithAlarm.clear();
     mPrefix = prefix;
     mSuffix = suffix;
+    invalidateFilter();
+}
 
-    KAEvent event;
-    const KAEvent::List events = AlarmCalendar::resources()->events(CalEvent::ACTIVE);
+/******************************************************************************
+* Called when events have been added to the calendar.
+*/
+void BirthdaySortModel::slotEventsAdded(const AkonadiModel::EventList& events)
+{
+    bool changed = false;
     for (int i = 0, end = events.count();  i < end;  ++i)
     {
-        KAEvent* event = events[i];
-        if (event->actionSubType() == KAEvent::MESSAGE
-        &&  event->recurType() == KARecurrence::ANNUAL_DATE
-        &&  (prefix.isEmpty()  ||  event->message().startsWith(prefix)))
-            mContactsWithAlarm.append(event->message());
+        if (addBirthdayAlarm(events[i].eventId(), events[i].event))
+            changed = true;
     }
+    if (changed)
+        invalidateFilter();
+}
 
-    invalidateFilter();
+/******************************************************************************
+* Called when events are about to be removed from the calendar.
+*/
+void BirthdaySortModel::slotEventsToBeRemoved(const AkonadiModel::EventList& events)
+{
+    bool changed = false;
+    for (int i = 0, end = events.count();  i < end;  ++i)
+    {
+        if (removeBirthdayAlarm(events[i].eventId()))
+            changed = true;
+    }
+    if (changed)
+        invalidateFilter();
+}
+
+/******************************************************************************
+* Called when an event in the calendar has changed.
+*/
+void BirthdaySortModel::slotEventChanged(const AkonadiModel::Event& event)
+{
+    const EventId id = event.eventId();
+    const bool removed = removeBirthdayAlarm(id);
+    const bool added   = addBirthdayAlarm(id, event.event);
+    if (removed  ||  added)
+        invalidateFilter();
+}
+
+/******************************************************************************
+* Add an event to the birthday alarm index, if it is a birthday alarm.
+* Reply = true if the event was added to the index.
+*/
+bool BirthdaySortModel::addBirthdayAlarm(const EventId& id, const KAEvent& event)
+{
+    if (event.category() != CalEvent::ACTIVE
+    ||  event.actionSubType() != KAEvent::MESSAGE
+    ||  event.recurType() != KARecurrence::ANNUAL_DATE
+    ||  mAlarmMessages.contains(id))
+        return false;
+    const QString message = event.message();
+    mAlarmMessages.insert(id, message);
+    ++mContactsWithAlarm[message];
+    return true;
+}
+
+/******************************************************************************
+* Remove an event from the birthday alarm index.
+* Reply = true if the event was in the index.
+*/
+bool BirthdaySortModel::removeBirthdayAlarm(const EventId& id)
+{
+    QHash<EventId, QString>::iterator it = mAlarmMessages.find(id);
+    if (it == mAlarmMessages.end())
+        return false;
+    QHash<QString, int>::iterator mit = mContactsWithAlarm.find(it.value());
+    if (mit != mContactsWithAlarm.end()  &&  --mit.value() <= 0)
+        mContactsWithAlarm.erase(mit);
+    mAlarmMessages.erase(it);
+    return true;
 }
 
 bool BirthdaySortModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
@@ -21,8 +21,12 @@
 #ifndef BIRTHDAYMODEL_H
 #define BIRTHDAYMODEL_H
 
+#include "akonadimodel.h"
+#include "eventid.h"
+
 #include <Akonadi/Contact/ContactsTreeModel>
 
+#include <QHash>
 #include <QSortFilterProxyModel>
 
 namespace Akonadi
@@ -77,10 +81,19 @@ class BirthdaySortModel : public QSortFilterProxyModel
     protected:
         bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
 
+    private Q_SLOTS:
+        void slotEventsAdded(const AkonadiModel::EventList&);
+        void slotEventsToBeRemoved(const AkonadiModel::EventList&);
+        void slotEventChanged(const AkonadiModel::Event&);
+
     private:
-        QStringList mContactsWithAlarm;
-        QString     mPrefix;
-        QString     mSuffix;
+        bool addBirthdayAlarm(const EventId&, const KAEvent&);
+        bool removeBirthdayAlarm(const EventId&);
+
+        QHash<QString, int>     mContactsWithAlarm;  // birthday alarm messages, with count of alarms for each
+        QHash<EventId, QString> mAlarmMessages;      // message text of each birthday alarm
+        QString                 mPrefix;
+        QString                 mSuffix;
 };
 
 #endif
@@ -42,6 +42,10 @@
 #include <KConfig>
 #include <KConfigGroup>
 
+#include <QCoreApplication>
+#include <QDBusPendingCallWatcher>
+#include <QPointer>
+#include <QQueue>
 #include <QTimer>
 #include <QStandardPaths>
 #include "kalarm_debug.h"
@@ -53,6 +57,9 @@ namespace
 {
 const QString KALARM_RESOURCE(QStringLiteral("akonadi_kalarm_resource"));
 const QString KALARM_DIR_RESOURCE(QStringLiteral("akonadi_kalarm_dir_resource"));
+
+const int BATCH_PROMPT_DELAY     = 500;   // milliseconds to collect calendars for a single update prompt
+const int MAX_CONCURRENT_UPDATES = 4;     // maximum number of calendar format updates to run at once
 }
 
 // Creates, or migrates from KResources, a single alarm calendar
@@ -123,18 +130,35 @@ class CalendarUpdater : public QObject
         bool isDuplicate() const   { return mDuplicate; }
         // Check whether any instance is for the given collection ID
         static bool containsCollection(Collection::Id);
+        // Queue this instance to be included in the next batched user prompt
+        void queuePrompt();
 
     public Q_SLOTS:
         bool update();
 
+    private Q_SLOTS:
+        void updateStorageFormatDone(QDBusPendingCallWatcher*);
+
     private:
-        static QList<CalendarUpdater*> mInstances;
+        bool needsUpdate() const;
+        void queueUpdate();
+        void executeUpdate();
+        void finishUpdate(const QString& errorMessage);
+        static void reportError(const QString& calendarName, const QString& errorMessage);
+        static void processPromptQueue();
+        static void executeQueuedUpdates();
+
+        static QList<CalendarUpdater*>  mInstances;
+        static QList<CalendarUpdater*>  mPromptQueue;   // instances awaiting the next batched user prompt
+        static QQueue<CalendarUpdater*> mUpdateQueue;   // instances awaiting execution of their update
+        static int                      mActiveUpdates; // number of updates currently executing
         Akonadi::Collection mCollection;
-        QObject*            mParent;
+        QPointer<QObject>   mParent;        // parent for prompts (may be deleted before this instance)
         const bool          mDirResource;
         const bool          mIgnoreKeepFormat;
         const bool          mNewCollection;
         const bool          mDuplicate;     // another instance is already updating this collection
+        bool                mActive;        // the update is currently executing
 };
 
 
@@ -395,11 +419,14 @@ void CalendarMigrator::updateToCurrentFormat(const Collection& collection, bool
         return;
     }
     CalendarUpdater* updater = new CalendarUpdater(collection, dirResource, ignoreKeepFormat, false, parent);
-    QTimer::singleShot(0, updater, &CalendarUpdater::update);
+    updater->queuePrompt();
 }
 
 
-QList<CalendarUpdater*> CalendarUpdater::mInstances;
+QList<CalendarUpdater*>  CalendarUpdater::mInstances;
+QList<CalendarUpdater*>  CalendarUpdater::mPromptQueue;
+QQueue<CalendarUpdater*> CalendarUpdater::mUpdateQueue;
+int                      CalendarUpdater::mActiveUpdates = 0;
 
 CalendarUpdater::CalendarUpdater(const Collection& collection, bool dirResource,
                                  bool ignoreKeepFormat, bool newCollection, QObject* parent)
@@ -408,7 +435,8 @@ CalendarUpdater::CalendarUpdater(const Collection& collection, bool dirResource,
       mDirResource(dirResource),
       mIgnoreKeepFormat(ignoreKeepFormat),
       mNewCollection(newCollection),
-      mDuplicate(containsCollection(collection.id()))
+      mDuplicate(containsCollection(collection.id())),
+      mActive(false)
 {
     mInstances.append(this);
 }
@@ -416,6 +444,21 @@ CalendarUpdater::CalendarUpdater(const Collection& collection, bool dirResource,
 CalendarUpdater::~CalendarUpdater()
 {
     mInstances.removeAll(this);
+    mPromptQueue.removeAll(this);
+    mUpdateQueue.removeAll(this);
+    if (mActive)
+    {
+        // The update was abandoned before completion. Release its slot so
+        // that queued updates can proceed, and tell the user.
+        qCWarning(KALARM_LOG) << mCollection.id() << "update abandoned";
+        --mActiveUpdates;
+        if (!QCoreApplication::closingDown())
+        {
+            const QString name = mCollection.name();
+            QTimer::singleShot(0, qApp, [name]() { reportError(name, i18nc("@info", "The update was cancelled")); });
+            QTimer::singleShot(0, qApp, &CalendarUpdater::executeQueuedUpdates);
+        }
+    }
 }
 
 bool CalendarUpdater::containsCollection(Collection::Id id)
@@ -428,91 +471,238 @@ bool CalendarUpdater::containsCollection(Collection::Id id)
     return false;
 }
 
+/******************************************************************************
+* Check whether the calendar needs to be, and can be, updated to the current
+* KAlarm format, and whether the user hasn't previously declined to update it.
+*/
+bool CalendarUpdater::needsUpdate() const
+{
+    if (mDuplicate     // prevent concurrent updates
+    ||  !mCollection.hasAttribute<CompatibilityAttribute>())   // must know format to update
+        return false;
+    const KACalendar::Compat compatibility = mCollection.attribute<CompatibilityAttribute>()->compatibility();
+    if (!(compatibility & ~KACalendar::Converted)
+    // The calendar is already in the current KAlarm format
+    ||  (compatibility & ~(KACalendar::Convertible | KACalendar::Converted)))
+        return false;   // the calendar format isn't convertible to the current KAlarm format
+    if (!mIgnoreKeepFormat
+    &&  mCollection.hasAttribute<CollectionAttribute>()
+    &&  mCollection.attribute<CollectionAttribute>()->keepFormat())
+    {
+        qCDebug(KALARM_LOG) << "Not updating format (previous user choice)";
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************************
+* Prompt the user whether to update the calendar to the current KAlarm format,
+* and if yes, schedule the update.
+* Reply = false if the user chose not to update the calendar.
+* Note that this instance will auto-delete when finished.
+*/
 bool CalendarUpdater::update()
 {
     qCDebug(KALARM_LOG) << mCollection.id() << (mDirResource ? "directory" : "file");
     bool result = true;
-    if (!mDuplicate     // prevent concurrent updates
-    &&  mCollection.hasAttribute<CompatibilityAttribute>())   // must know format to update
-    {
-        const CompatibilityAttribute* compatAttr = mCollection.attribute<CompatibilityAttribute>();
-        const KACalendar::Compat compatibility = compatAttr->compatibility();
-        if ((compatibility & ~KACalendar::Converted)
-        // The calendar isn't in the current KAlarm format
-        &&  !(compatibility & ~(KACalendar::Convertible | KACalendar::Converted)))
+    if (needsUpdate())
+    {
+        // The user hasn't previously said not to convert it
+        const QString versionString = KAlarmCal::getVersionString(mCollection.attribute<CompatibilityAttribute>()->version());
+        const QString msg = KAlarm::conversionPrompt(mCollection.name(), versionString, false);
+        qCDebug(KALARM_LOG) << "Version" << versionString;
+        if (KAMessageBox::warningYesNo(qobject_cast<QWidget*>(mParent), msg) != KMessageBox::Yes)
+            result = false;   // the user chose not to update the calendar
+        if (!mNewCollection)
         {
-            // The calendar format is convertible to the current KAlarm format
-            if (!mIgnoreKeepFormat
-            &&  mCollection.hasAttribute<CollectionAttribute>()
-            &&  mCollection.attribute<CollectionAttribute>()->keepFormat())
-                qCDebug(KALARM_LOG) << "Not updating format (previous user choice)";
-            else
-            {
-                // The user hasn't previously said not to convert it
-                const QString versionString = KAlarmCal::getVersionString(compatAttr->version());
-                const QString msg = KAlarm::conversionPrompt(mCollection.name(), versionString, false);
-                qCDebug(KALARM_LOG) << "Version" << versionString;
-                if (KAMessageBox::warningYesNo(qobject_cast<QWidget*>(mParent), msg) != KMessageBox::Yes)
-                    result = false;   // the user chose not to update the calendar
-                else
-                {
-                    // Tell the resource to update the backend storage format
-                    QString errmsg;
-                    if (!mNewCollection)
-                    {
-                        // Refetch the collection's details because anything could
-                        // have happened since the prompt was first displayed.
-                        if (!AkonadiModel::instance()->refresh(mCollection))
-                            errmsg = i18nc("@info", "Invalid collection");
-                    }
-                    if (errmsg.isEmpty())
-                    {
-                        const AgentInstance agent = AgentManager::self()->instance(mCollection.resource());
-                        if (mDirResource)
-                            CalendarMigrator::updateStorageFormat<OrgKdeAkonadiKAlarmDirSettingsInterface>(agent, errmsg, mParent);
-                        else
-                            CalendarMigrator::updateStorageFormat<OrgKdeAkonadiKAlarmSettingsInterface>(agent, errmsg, mParent);
-                    }
-                    if (!errmsg.isEmpty())
-                    {
-                        KAMessageBox::error(MainWindow::mainMainWindow(),
-                                            xi18nc("@info", "%1<nl/>(%2)",
-                                                  xi18nc("@info/plain", "Failed to update format of calendar <resource>%1</resource>", mCollection.name()),
-                                            errmsg));
-                    }
-                }
-                if (!mNewCollection)
-                {
-                    // Record the user's choice of whether to update the calendar
-                    const QModelIndex ix = AkonadiModel::instance()->collectionIndex(mCollection);
-                    AkonadiModel::instance()->setData(ix, !result, AkonadiModel::KeepFormatRole);
-                }
-            }
+            // Record the user's choice of whether to update the calendar
+            const QModelIndex ix = AkonadiModel::instance()->collectionIndex(mCollection);
+            AkonadiModel::instance()->setData(ix, !result, AkonadiModel::KeepFormatRole);
+        }
+        if (result)
+        {
+            queueUpdate();
+            return true;
         }
     }
     deleteLater();
     return result;
 }
 
+/******************************************************************************
+* Queue this instance to be included in a single prompt, which asks the user
+* whether to update all calendars which were queued at around the same time.
+* This avoids a succession of prompts at start-up, when a number of calendars
+* may be in an old format.
+*/
+void CalendarUpdater::queuePrompt()
+{
+    if (mPromptQueue.isEmpty())
+        QTimer::singleShot(BATCH_PROMPT_DELAY, &CalendarUpdater::processPromptQueue);
+    mPromptQueue.append(this);
+}
+
+/******************************************************************************
+* Prompt the user once for all the calendars queued by queuePrompt() which
+* can be updated, and schedule the updates for those which the user approves.
+*/
+void CalendarUpdater::processPromptQueue()
+{
+    const QList<CalendarUpdater*> queued = mPromptQueue;
+    mPromptQueue.clear();
+    QList<CalendarUpdater*> updaters;
+    QStringList names;
+    for (CalendarUpdater* updater : queued)
+    {
+        qCDebug(KALARM_LOG) << updater->mCollection.id() << (updater->mDirResource ? "directory" : "file");
+        if (updater->needsUpdate())
+        {
+            updaters += updater;
+            names += updater->mCollection.name();
+        }
+        else
+            updater->deleteLater();
+    }
+    if (updaters.isEmpty())
+        return;
+
+    QWidget* parent = qobject_cast<QWidget*>(updaters[0]->mParent);
+    int answer;
+    if (updaters.count() == 1)
+    {
+        const Collection& collection = updaters[0]->mCollection;
+        const QString versionString = KAlarmCal::getVersionString(collection.attribute<CompatibilityAttribute>()->version());
+        qCDebug(KALARM_LOG) << "Version" << versionString;
+        answer = KAMessageBox::warningYesNo(parent, KAlarm::conversionPrompt(collection.name(), versionString, false));
+    }
+    else
+        answer = KAMessageBox::warningYesNoList(parent, KAlarm::conversionPrompt(updaters.count()), names);
+    const bool update = (answer == KMessageBox::Yes);
+
+    for (CalendarUpdater* updater : updaters)
+    {
+        if (!updater->mNewCollection)
+        {
+            // Record the user's choice of whether to update the calendar
+            const QModelIndex ix = AkonadiModel::instance()->collectionIndex(updater->mCollection);
+            AkonadiModel::instance()->setData(ix, !update, AkonadiModel::KeepFormatRole);
+        }
+        if (update)
+            updater->queueUpdate();
+        else
+            updater->deleteLater();
+    }
+}
+
+/******************************************************************************
+* Queue the update of the calendar's backend storage format. Updates are
+* executed concurrently, up to a maximum number at a time.
+*/
+void CalendarUpdater::queueUpdate()
+{
+    mUpdateQueue.enqueue(this);
+    executeQueuedUpdates();
+}
+
+/******************************************************************************
+* Start execution of queued updates, up to the maximum number which may run
+* concurrently.
+*/
+void CalendarUpdater::executeQueuedUpdates()
+{
+    while (mActiveUpdates < MAX_CONCURRENT_UPDATES  &&  !mUpdateQueue.isEmpty())
+    {
+        ++mActiveUpdates;
+        CalendarUpdater* updater = mUpdateQueue.dequeue();
+        updater->mActive = true;
+        updater->executeUpdate();
+    }
+}
+
+/******************************************************************************
+* Tell the resource to update the backend storage format.
+*/
+void CalendarUpdater::executeUpdate()
+{
+    qCDebug(KALARM_LOG) << mCollection.id();
+    QString errmsg;
+    if (!mNewCollection)
+    {
+        // Refetch the collection's details because anything could
+        // have happened since the prompt was first displayed.
+        if (!AkonadiModel::instance()->refresh(mCollection))
+            errmsg = i18nc("@info", "Invalid collection");
+    }
+    if (errmsg.isEmpty())
+    {
+        const AgentInstance agent = AgentManager::self()->instance(mCollection.resource());
+        QDBusPendingCallWatcher* watcher = mDirResource
+                ? CalendarMigrator::updateStorageFormat<OrgKdeAkonadiKAlarmDirSettingsInterface>(agent, errmsg, this)
+                : CalendarMigrator::updateStorageFormat<OrgKdeAkonadiKAlarmSettingsInterface>(agent, errmsg, this);
+        if (watcher)
+        {
+            connect(watcher, &QDBusPendingCallWatcher::finished, this, &CalendarUpdater::updateStorageFormatDone);
+            return;
+        }
+    }
+    finishUpdate(errmsg);
+}
+
+/******************************************************************************
+* Called when the resource has replied to the request to update the backend
+* storage format.
+*/
+void CalendarUpdater::updateStorageFormatDone(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+    finishUpdate(watcher->isError() ? watcher->error().message() : QString());
+}
+
+/******************************************************************************
+* Called when an update has completed or failed. Report any error, and start
+* the next queued update.
+*/
+void CalendarUpdater::finishUpdate(const QString& errmsg)
+{
+    qCDebug(KALARM_LOG) << mCollection.id() << (errmsg.isEmpty() ? "success" : "error");
+    mActive = false;
+    --mActiveUpdates;
+    deleteLater();
+    executeQueuedUpdates();
+    if (!errmsg.isEmpty())
+        reportError(mCollection.name(), errmsg);
+}
+
+/******************************************************************************
+* Tell the user that updating a calendar's format failed.
+*/
+void CalendarUpdater::reportError(const QString& calendarName, const QString& errmsg)
+{
+    KAMessageBox::error(MainWindow::mainMainWindow(),
+                        xi18nc("@info", "%1<nl/>(%2)",
+                              xi18nc("@info/plain", "Failed to update format of calendar <resource>%1</resource>", calendarName),
+                        errmsg));
+}
+
 /******************************************************************************
 * Tell an Akonadi resource to update the backend storage format to the current
 * KAlarm format.
-* Reply = true if success; if false, 'errorMessage' contains the error message.
+* Reply = watcher for the resource's reply if success. The caller must delete it.
+*       = 0 if error: 'errorMessage' contains the error message.
 */
-template <class Interface> bool CalendarMigrator::updateStorageFormat(const AgentInstance& agent, QString& errorMessage, QObject* parent)
+template <class Interface> QDBusPendingCallWatcher* CalendarMigrator::updateStorageFormat(const AgentInstance& agent, QString& errorMessage, QObject* parent)
 {
     qCDebug(KALARM_LOG);
     Interface* iface = getAgentInterface<Interface>(agent, errorMessage, parent);
     if (!iface)
     {
         qCDebug(KALARM_LOG) << errorMessage;
-        return false;
+        return nullptr;
     }
     iface->setUpdateStorageFormat(true);
-    iface->save();
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(iface->save(), parent);
     delete iface;
-    qCDebug(KALARM_LOG) << "true";
-    return true;
+    return watcher;
 }
 
 /******************************************************************************
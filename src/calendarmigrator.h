@@ -27,6 +27,7 @@
 #include <AkonadiCore/collection.h>
 
 class KJob;
+class QDBusPendingCallWatcher;
 namespace KRES { class Resource; }
 namespace Akonadi { class CollectionFetchJob; }
 
@@ -67,7 +68,7 @@ class CalendarMigrator : public QObject
         CalendarMigrator(QObject* parent = nullptr);
         void migrateOrCreate();
         void createDefaultResources();
-        template <class Interface> static bool updateStorageFormat(const Akonadi::AgentInstance&, QString& errorMessage, QObject* parent);
+        template <class Interface> static QDBusPendingCallWatcher* updateStorageFormat(const Akonadi::AgentInstance&, QString& errorMessage, QObject* parent);
 
         static CalendarMigrator* mInstance;
         QList<CalendarCreator*> mCalendarsPending;   // pending calendar migration or creation jobs
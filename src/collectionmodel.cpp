@@ -244,16 +244,28 @@ QVariant CollectionListModel::data(const QModelIndex& index, int role) const
 = which are disabled for that alarm type, are unchecked.
 =============================================================================*/
 
-CollectionListModel* CollectionCheckListModel::mModel = nullptr;
-int                  CollectionCheckListModel::mInstanceCount = 0;
+CollectionListModel*                  CollectionCheckListModel::mModel = nullptr;
+QHash<int, CollectionCheckListModel*> CollectionCheckListModel::mInstances;
+
+/******************************************************************************
+* Return the shared model for an alarm type, creating it if necessary.
+* The models are kept until the application exits, so that collection changes
+* are processed once, regardless of how many views display them.
+*/
+CollectionCheckListModel* CollectionCheckListModel::instance(CalEvent::Type type)
+{
+    CollectionCheckListModel*& model = mInstances[type];
+    if (!model)
+        model = new CollectionCheckListModel(type, AkonadiModel::instance());
+    return model;
+}
 
 CollectionCheckListModel::CollectionCheckListModel(CalEvent::Type type, QObject* parent)
     : KCheckableProxyModel(parent),
       mAlarmType(type)
 {
-    ++mInstanceCount;
     if (!mModel)
-        mModel = new CollectionListModel(nullptr);
+        mModel = new CollectionListModel(AkonadiModel::instance());
     setSourceModel(mModel);    // the source model is NOT filtered by alarm type
     mSelectionModel = new QItemSelectionModel(mModel);
     setSelectionModel(mSelectionModel);
@@ -270,21 +282,12 @@ CollectionCheckListModel::CollectionCheckListModel(CalEvent::Type type, QObject*
                                       this, &CollectionCheckListModel::collectionStatusChanged);
 
     // Initialise checked status for all collections.
-    // Note that this is only necessary if the model is recreated after
-    // being deleted.
+    // Note that this is only necessary if the model is created after the
+    // collections have already been inserted into the source model.
     for (int row = 0, count = mModel->rowCount();  row < count;  ++row)
         setSelectionStatus(mModel->collection(row), mModel->index(row, 0));
 }
 
-CollectionCheckListModel::~CollectionCheckListModel()
-{
-    if (--mInstanceCount <= 0)
-    {
-        delete mModel;
-        mModel = nullptr;
-    }
-}
-
 
 /******************************************************************************
 * Return the collection for a given row.
@@ -473,9 +476,9 @@ void CollectionCheckListModel::setSelectionStatus(const Collection& collection,
 =============================================================================*/
 CollectionFilterCheckListModel::CollectionFilterCheckListModel(QObject* parent)
     : QSortFilterProxyModel(parent),
-      mActiveModel(new CollectionCheckListModel(CalEvent::ACTIVE, this)),
-      mArchivedModel(new CollectionCheckListModel(CalEvent::ARCHIVED, this)),
-      mTemplateModel(new CollectionCheckListModel(CalEvent::TEMPLATE, this)),
+      mActiveModel(CollectionCheckListModel::instance(CalEvent::ACTIVE)),
+      mArchivedModel(CollectionCheckListModel::instance(CalEvent::ARCHIVED)),
+      mTemplateModel(CollectionCheckListModel::instance(CalEvent::TEMPLATE)),
       mAlarmType(CalEvent::EMPTY)
 {
     setDynamicSortFilter(true);
@@ -655,6 +658,7 @@ bool CollectionView::viewportEvent(QEvent* e)
 
 CollectionControlModel* CollectionControlModel::mInstance = nullptr;
 bool                    CollectionControlModel::mAskDestination = false;
+QHash<int, CollectionListModel*> CollectionControlModel::mDestinationModels;
 
 CollectionControlModel* CollectionControlModel::instance()
 {
@@ -664,8 +668,7 @@ CollectionControlModel* CollectionControlModel::instance()
 }
 
 CollectionControlModel::CollectionControlModel(QObject* parent)
-    : FavoriteCollectionsModel(AkonadiModel::instance(), KConfigGroup(KSharedConfig::openConfig(), "Collections"), parent),
-      mPopulatedCheckLoop(nullptr)
+    : FavoriteCollectionsModel(AkonadiModel::instance(), KConfigGroup(KSharedConfig::openConfig(), "Collections"), parent)
 {
     // Initialise the list of enabled collections
     EntityMimeTypeFilterModel* filter = new EntityMimeTypeFilterModel(this);
@@ -1196,11 +1199,7 @@ Collection CollectionControlModel::destination(CalEvent::Type type, QWidget* pro
         return standard;
 
     // Prompt for which collection to use
-    CollectionListModel* model = new CollectionListModel(promptParent);
-    model->setFilterWritable(true);
-    model->setFilterEnabled(true);
-    model->setEventTypeFilter(type);
-    model->useCollectionColour(false);
+    CollectionListModel* model = destinationModel(type);
     Collection col;
     switch (model->rowCount())
     {
@@ -1227,6 +1226,24 @@ Collection CollectionControlModel::destination(CalEvent::Type type, QWidget* pro
     return col;
 }
 
+/******************************************************************************
+* Return the model listing the collections which alarms of a given type can be
+* stored in, creating it if necessary. The model is kept for reuse.
+*/
+CollectionListModel* CollectionControlModel::destinationModel(CalEvent::Type type)
+{
+    CollectionListModel*& model = mDestinationModels[type];
+    if (!model)
+    {
+        model = new CollectionListModel(AkonadiModel::instance());
+        model->setFilterWritable(true);
+        model->setFilterEnabled(true);
+        model->setEventTypeFilter(type);
+        model->useCollectionColour(false);
+    }
+    return model;
+}
+
 /******************************************************************************
 * Return the enabled collections which contain a specified mime type.
 * If 'writable' is true, only writable collections are included.
@@ -1282,26 +1299,37 @@ bool CollectionControlModel::isPopulated(Collection::Id colId)
 }
 
 /******************************************************************************
-* Wait for one or all enabled collections to be populated.
-* Reply = true if successful.
+* Call a function once one or all enabled collections have been populated, or
+* when a timeout expires.
 */
-bool CollectionControlModel::waitUntilPopulated(Collection::Id colId, int timeout)
-{
-    qCDebug(KALARM_LOG);
-    int result = 1;
-    AkonadiModel* model = AkonadiModel::instance();
-    while (!model->isCollectionTreeFetched()
-       ||  !isPopulated(colId))
+void CollectionControlModel::whenPopulated(Collection::Id colId, int timeout, QObject* context,
+                                           const std::function<void(bool)>& function)
+{
+    qCDebug(KALARM_LOG) << colId;
+    PopulatedRequest* request = new PopulatedRequest;
+    request->collectionId = colId;
+    request->context      = context;
+    request->function     = function;
+    request->timer        = nullptr;
+    mPopulatedRequests.append(request);
+    if (timeout > 0)
     {
-        if (!mPopulatedCheckLoop)
-            mPopulatedCheckLoop = new QEventLoop(this);
-        if (timeout > 0)
-            QTimer::singleShot(timeout * 1000, mPopulatedCheckLoop, &QEventLoop::quit);
-        result = mPopulatedCheckLoop->exec();
+        request->timer = new QTimer(this);
+        request->timer->setSingleShot(true);
+        connect(request->timer, &QTimer::timeout, this, [this, request]()
+        {
+            qCDebug(KALARM_LOG) << "Timed out:" << request->collectionId;
+            mPopulatedRequests.removeAll(request);
+            request->timer->deleteLater();
+            if (request->context)
+                request->function(false);
+            delete request;
+        });
+        request->timer->start(timeout * 1000);
     }
-    delete mPopulatedCheckLoop;
-    mPopulatedCheckLoop = nullptr;
-    return result;
+    // Ensure that the function is called asynchronously even if the
+    // collections are already populated.
+    QTimer::singleShot(0, this, &CollectionControlModel::collectionPopulated);
 }
 
 /******************************************************************************
@@ -1309,8 +1337,7 @@ bool CollectionControlModel::waitUntilPopulated(Collection::Id colId, int timeou
 */
 void CollectionControlModel::reset()
 {
-    delete mPopulatedCheckLoop;
-    mPopulatedCheckLoop = nullptr;
+    finishPopulatedRequests(true, false);
 
     // Clear the collections list. This is required because addCollection() or
     // setCollections() don't work if the collections which they specify are
@@ -1319,12 +1346,37 @@ void CollectionControlModel::reset()
 }
 
 /******************************************************************************
-* Exit from the populated event loop when a collection has been populated.
+* Called when the collection tree has been fetched, or a collection has been
+* populated. Notify any requests whose collections are now populated.
 */
 void CollectionControlModel::collectionPopulated()
 {
-    if (mPopulatedCheckLoop)
-        mPopulatedCheckLoop->exit(1);
+    if (!mPopulatedRequests.isEmpty()  &&  AkonadiModel::instance()->isCollectionTreeFetched())
+        finishPopulatedRequests(false, true);
+}
+
+/******************************************************************************
+* Call the functions for all pending whenPopulated() requests, or only for
+* those whose collections are now populated, and remove them from the list.
+*/
+void CollectionControlModel::finishPopulatedRequests(bool all, bool result)
+{
+    QList<PopulatedRequest*> finished;
+    for (int i = mPopulatedRequests.count();  --i >= 0;  )
+    {
+        PopulatedRequest* request = mPopulatedRequests[i];
+        if (all  ||  isPopulated(request->collectionId))
+            finished.prepend(mPopulatedRequests.takeAt(i));
+    }
+    // Note that a function may add a new request, so don't access
+    // mPopulatedRequests while calling them.
+    for (PopulatedRequest* request : finished)
+    {
+        delete request->timer;
+        if (request->context)
+            request->function(result);
+        delete request;
+    }
 }
 
 /******************************************************************************
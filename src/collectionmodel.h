@@ -29,12 +29,16 @@
 #include <kcheckableproxymodel.h>
 #include <kdescendantsproxymodel.h>
 
+#include <QHash>
 #include <QSortFilterProxyModel>
 #include <QListView>
+#include <QPointer>
+
+#include <functional>
 
 using namespace KAlarmCal;
 
-class QEventLoop;
+class QTimer;
 namespace Akonadi
 {
     class EntityMimeTypeFilterModel;
@@ -73,13 +77,16 @@ class CollectionListModel : public KDescendantsProxyModel
 = An alarm type is specified, whereby Collections which are enabled for that
 = alarm type are checked; Collections which do not contain that alarm type, or
 = which are disabled for that alarm type, are unchedked.
+= Since the checked status is global, one instance for each alarm type is shared
+= by all users.
 =============================================================================*/
 class CollectionCheckListModel : public KCheckableProxyModel
 {
         Q_OBJECT
     public:
-        explicit CollectionCheckListModel(CalEvent::Type, QObject* parent = nullptr);
-        ~CollectionCheckListModel();
+        /** Return the shared model instance for an alarm type. */
+        static CollectionCheckListModel* instance(CalEvent::Type);
+
         Akonadi::Collection collection(int row) const;
         Akonadi::Collection collection(const QModelIndex&) const;
         QVariant data(const QModelIndex&, int role = Qt::DisplayRole) const override;
@@ -94,10 +101,11 @@ class CollectionCheckListModel : public KCheckableProxyModel
         void collectionStatusChanged(const Akonadi::Collection&, AkonadiModel::Change, const QVariant& value, bool inserted);
 
     private:
+        CollectionCheckListModel(CalEvent::Type, QObject* parent);
         void setSelectionStatus(const Akonadi::Collection&, const QModelIndex&);
 
-        static CollectionListModel* mModel;
-        static int             mInstanceCount;
+        static CollectionListModel* mModel;   // unfiltered list of all collections
+        static QHash<int, CollectionCheckListModel*> mInstances;   // instance for each alarm type
         CalEvent::Type mAlarmType;     // alarm type contained in this model
         QItemSelectionModel*   mSelectionModel;
 };
@@ -269,13 +277,19 @@ class CollectionControlModel : public Akonadi::FavoriteCollectionsModel
          */
         static bool isPopulated(Akonadi::Collection::Id);
 
-        /** Wait until one or all enabled collections have been populated,
-         *  i.e. whether their items have been fetched.
-         *  @param   colId    collection ID, or -1 for all collections
-         *  @param   timeout  timeout in seconds, or 0 for no timeout
-         *  @return  true if successful.
+        /** Call a function once one or all enabled collections have been
+         *  populated, i.e. once their items have been fetched, or when a timeout
+         *  expires. The function is always called asynchronously, even if the
+         *  collections are already populated, and it is not called at all if
+         *  @p context is deleted first.
+         *  @param colId     collection ID, or -1 for all collections
+         *  @param timeout   timeout in seconds, or 0 for no timeout
+         *  @param context   object whose lifetime limits the request
+         *  @param function  function to call, with parameter true if populated,
+         *                   or false if timed out or the Akonadi server stopped.
          */
-        bool waitUntilPopulated(Akonadi::Collection::Id colId = -1, int timeout = 0);
+        void whenPopulated(Akonadi::Collection::Id colId, int timeout, QObject* context,
+                           const std::function<void(bool)>& function);
 
         QVariant data(const QModelIndex&, int role = Qt::DisplayRole) const override;
 
@@ -288,14 +302,24 @@ class CollectionControlModel : public Akonadi::FavoriteCollectionsModel
         void collectionPopulated();
 
     private:
+        struct PopulatedRequest
+        {
+            Akonadi::Collection::Id   collectionId;
+            QPointer<QObject>         context;
+            std::function<void(bool)> function;
+            QTimer*                   timer;
+        };
         explicit CollectionControlModel(QObject* parent = nullptr);
         void findEnabledCollections(const Akonadi::EntityMimeTypeFilterModel*, const QModelIndex& parent, Akonadi::Collection::List&) const;
         CalEvent::Types setEnabledStatus(const Akonadi::Collection&, CalEvent::Types, bool inserted);
         static CalEvent::Types checkTypesToEnable(const Akonadi::Collection&, const Akonadi::Collection::List&, CalEvent::Types);
+        void finishPopulatedRequests(bool all, bool result);
+        static CollectionListModel* destinationModel(CalEvent::Type);
 
         static CollectionControlModel* mInstance;
+        static QHash<int, CollectionListModel*> mDestinationModels;   // writable enabled collections for each alarm type
         static bool mAskDestination;
-        QEventLoop* mPopulatedCheckLoop;
+        QList<PopulatedRequest*> mPopulatedRequests;   // pending whenPopulated() requests
 };
 
 #endif // COLLECTIONMODEL_H
@@ -81,6 +81,8 @@ static const char TEMPLATE_DIALOG_NAME[] = "EditTemplateDialog";
 static const char EDIT_MORE_GROUP[] = "ShowOpts";
 static const char EDIT_MORE_KEY[]   = "EditMore";
 static const int  maxDelayTime = 99*60 + 59;    // < 100 hours
+static const int  POOL_BUILD_DELAY = 2000;   // milliseconds to wait before preparing a New Alarm dialog
+static const int  POOL_EXPIRY      = 30;     // minutes to keep unused prepared New Alarm dialogs
 
 inline QString recurText(const KAEvent& event)
 {
@@ -92,16 +94,39 @@ inline QString recurText(const KAEvent& event)
     return i18nc("@title:tab", "Recurrence - [%1]", r);
 }
 
-QList<EditAlarmDlg*> EditAlarmDlg::mWindowList;
+QList<EditAlarmDlg*>      EditAlarmDlg::mWindowList;
+QHash<int, EditAlarmDlg*> EditAlarmDlg::mPool;
+QSet<int>                 EditAlarmDlg::mPoolTypes;
+QTimer*                   EditAlarmDlg::mPoolExpiryTimer = nullptr;
+bool                      EditAlarmDlg::mPoolBuildPending = false;
+bool                      EditAlarmDlg::mPoolClosing = false;
 
 // Collect these widget labels together to ensure consistent wording and
 // translations across different modules.
 QString EditAlarmDlg::i18n_chk_ShowInKOrganizer()   { return i18nc("@option:check", "Show in KOrganizer"); }
 
 
+/******************************************************************************
+* Create a New Alarm or New Template dialog for the specified alarm type.
+* For a New Alarm dialog, a prepared dialog is used if one is available.
+*/
 EditAlarmDlg* EditAlarmDlg::create(bool Template, Type type, QWidget* parent, GetResourceType getResource)
 {
     qCDebug(KALARM_LOG);
+    if (Template  ||  getResource != RES_PROMPT)
+        return createNew(Template, type, parent, getResource);
+    EditAlarmDlg* dlg = mPool.take(type);
+    if (dlg)
+        dlg->reuse(parent);
+    else
+        dlg = createNew(false, type, parent, getResource);
+    mPoolTypes.insert(type);
+    prewarm();    // prepare a replacement dialog once idle
+    return dlg;
+}
+
+EditAlarmDlg* EditAlarmDlg::createNew(bool Template, Type type, QWidget* parent, GetResourceType getResource)
+{
     switch (type)
     {
         case DISPLAY:  return new EditDisplayAlarmDlg(Template, parent, getResource);
@@ -503,14 +528,128 @@ EditAlarmDlg::~EditAlarmDlg()
     mButtonBox = nullptr;    // prevent text edit contentsChanged() signal triggering a crash
     delete mSavedEvent;
     mWindowList.removeAll(this);
+    for (QHash<int, EditAlarmDlg*>::Iterator it = mPool.begin();  it != mPool.end();  ++it)
+    {
+        if (it.value() == this)
+        {
+            mPool.erase(it);
+            break;
+        }
+    }
 }
 
 /******************************************************************************
-* Return the number of instances.
+* Return the number of instances, excluding prepared dialogs which are not in
+* use.
 */
 int EditAlarmDlg::instanceCount()
 {
-    return mWindowList.count();
+    return mWindowList.count() - mPool.count();
+}
+
+/******************************************************************************
+* Schedule the creation of any missing prepared New Alarm dialogs, and restart
+* the timer which releases their memory if they remain unused.
+* One dialog is kept prepared for each alarm type which has been used in a New
+* Alarm dialog; until one has been used, only a display alarm dialog is
+* prepared. After the pool has expired, it is rebuilt the next time this is
+* called, i.e. when the main window is shown or a New Alarm dialog is used.
+*/
+void EditAlarmDlg::prewarm()
+{
+    if (mPoolClosing)
+        return;
+    if (!mPoolExpiryTimer)
+    {
+        mPoolExpiryTimer = new QTimer(qApp);
+        mPoolExpiryTimer->setSingleShot(true);
+        QObject::connect(mPoolExpiryTimer, &QTimer::timeout, &EditAlarmDlg::discardPool);
+        // The prepared dialogs' options are determined by the configuration,
+        // so replace them when it changes.
+        QObject::connect(Preferences::self(), &KCoreConfigSkeleton::configChanged, mPoolExpiryTimer, []()
+                         {
+                             discardPool();
+                             prewarm();
+                         });
+        QObject::connect(qApp, &QCoreApplication::aboutToQuit, mPoolExpiryTimer, []()
+                         {
+                             mPoolClosing = true;
+                             discardPool();
+                         });
+    }
+    if (mPoolTypes.isEmpty())
+        mPoolTypes.insert(DISPLAY);
+    mPoolExpiryTimer->start(POOL_EXPIRY * 60 * 1000);
+    if (!mPoolBuildPending)
+    {
+        mPoolBuildPending = true;
+        QTimer::singleShot(POOL_BUILD_DELAY, mPoolExpiryTimer, &EditAlarmDlg::prewarmNext);
+    }
+}
+
+/******************************************************************************
+* Create the next missing prepared New Alarm dialog. Only one dialog is created
+* at a time, to avoid blocking the user interface for long.
+*/
+void EditAlarmDlg::prewarmNext()
+{
+    mPoolBuildPending = false;
+    if (!AlarmCalendar::resources()  ||  mPoolClosing  ||  !mPoolExpiryTimer->isActive())
+        return;
+    if (QApplication::activeModalWidget()  ||  QApplication::activePopupWidget()
+    ||  QApplication::mouseButtons() != Qt::NoButton)
+    {
+        // The user is busy, so wait until later
+        mPoolBuildPending = true;
+        QTimer::singleShot(POOL_BUILD_DELAY, mPoolExpiryTimer, &EditAlarmDlg::prewarmNext);
+        return;
+    }
+    static const Type types[] = { DISPLAY, COMMAND, EMAIL, AUDIO };
+    for (Type type : types)
+    {
+        if (mPoolTypes.contains(type)  &&  !mPool.contains(type))
+        {
+            qCDebug(KALARM_LOG) << "Preparing dialog type" << type;
+            EditAlarmDlg* dlg = createNew(false, type, nullptr, RES_PROMPT);
+            if (dlg)
+                mPool[type] = dlg;
+            if (mPool.count() < mPoolTypes.count())
+            {
+                mPoolBuildPending = true;
+                QTimer::singleShot(0, mPoolExpiryTimer, &EditAlarmDlg::prewarmNext);
+            }
+            return;
+        }
+    }
+}
+
+/******************************************************************************
+* Delete all prepared New Alarm dialogs which are not in use.
+*/
+void EditAlarmDlg::discardPool()
+{
+    if (!mPool.isEmpty())
+        qCDebug(KALARM_LOG) << mPool.count();
+    const QList<EditAlarmDlg*> dialogs = mPool.values();
+    mPool.clear();
+    qDeleteAll(dialogs);
+}
+
+/******************************************************************************
+* Prepare a dialog taken from the pool of prepared New Alarm dialogs for use,
+* updating any values which may have become out of date since it was created.
+*/
+void EditAlarmDlg::reuse(QWidget* parent)
+{
+    qCDebug(KALARM_LOG);
+    if (parent)
+        setParent(parent, windowFlags());
+    KConfigGroup config(KSharedConfig::openConfig(), EDIT_MORE_GROUP);
+    const bool more = config.readEntry(EDIT_MORE_KEY, false);
+    if (more != mShowingMore)
+        showOptions(more);
+    initValues(nullptr);
+    mDesktop = KWindowSystem::currentDesktop();
 }
 
 /******************************************************************************
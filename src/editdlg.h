@@ -28,6 +28,8 @@
 #include <AkonadiCore/collection.h>
 
 #include <QDialog>
+#include <QHash>
+#include <QSet>
 #include <QTime>
 
 class QLabel;
@@ -50,6 +52,7 @@ class Reminder;
 class StackedScrollGroup;
 class TimeSpinBox;
 class QDialogButtonBox;
+class QTimer;
 
 using namespace KAlarmCal;
 
@@ -87,6 +90,12 @@ class EditAlarmDlg : public QDialog
         static int      instanceCount();
         static QString  i18n_chk_ShowInKOrganizer();   // text of 'Show in KOrganizer' checkbox
 
+        /** Prepare hidden New Alarm dialogs, one for each alarm type, during
+         *  idle time, ready to be returned immediately by create().
+         *  The prepared dialogs are discarded if they remain unused for a while.
+         */
+        static void     prewarm();
+
     protected:
         EditAlarmDlg(bool Template, KAEvent::SubAction, QWidget* parent = nullptr,
                      GetResourceType = RES_PROMPT);
@@ -142,6 +151,10 @@ class EditAlarmDlg : public QDialog
         void            focusFixTimer();
 
     private:
+        static EditAlarmDlg* createNew(bool Template, Type, QWidget* parent, GetResourceType);
+        static void     prewarmNext();
+        static void     discardPool();
+        void            reuse(QWidget* parent);
         void            init(const KAEvent* event, GetResourceType getResource);
         void            initValues(const KAEvent*);
         void            setEvent(KAEvent&, const QString& text, bool trial);
@@ -160,6 +173,11 @@ class EditAlarmDlg : public QDialog
 
     private:
         static QList<EditAlarmDlg*> mWindowList;  // list of instances
+        static QHash<int, EditAlarmDlg*> mPool;   // prepared New Alarm dialogs, indexed by Type
+        static QSet<int>    mPoolTypes;           // alarm types for which to keep a prepared dialog
+        static QTimer*      mPoolExpiryTimer;     // discards the prepared dialogs when they are unused
+        static bool         mPoolBuildPending;    // a prepared dialog is due to be created
+        static bool         mPoolClosing;         // the application is quitting, so don't prepare dialogs
         QTabWidget*         mTabs;                // the tabs in the dialog
         StackedScrollGroup* mTabScrollGroup;
         int                 mMainPageIndex;
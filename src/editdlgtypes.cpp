@@ -1672,11 +1672,12 @@ bool EditAudioAlarmDlg::checkText(QString& result, bool showErrorMessage) const
 */
 void EditAudioAlarmDlg::slotTry()
 {
-    if (!MessageWin::isAudioPlaying())
+    if (!mMessageWin)
         EditAlarmDlg::slotTry();   // play the audio file
-    else if (mMessageWin)
+    else
     {
-        mMessageWin->stopAudio();
+        // Stop only the test sound, leaving any alarms' sounds playing
+        mMessageWin->stopWindowAudio();
         mMessageWin = nullptr;
     }
 }
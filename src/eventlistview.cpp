@@ -26,6 +26,7 @@
 #include <kglobalsettings.h>
 #include <KLocalizedString>
 
+#include <QItemSelectionModel>
 #include <QMouseEvent>
 #include <QToolTip>
 #include <QApplication>
@@ -124,6 +125,50 @@ QVector<KAEvent> EventListView::selectedEvents() const
     return elist;
 }
 
+/******************************************************************************
+* Return the IDs of the selected events.
+* This avoids copying the events, so is preferable to selectedEvents() when a
+* large number of items may be selected. The selection ranges are iterated
+* directly, rather than building a list of every selected index.
+*/
+QVector<EventId> EventListView::selectedEventIds() const
+{
+    QVector<EventId> ids;
+    const QItemSelection selection = selectionModel()->selection();
+    if (!selection.isEmpty())
+    {
+        const ItemListModel* model = itemModel();
+        ids.reserve(selectedCount());
+        for (const QItemSelectionRange& range : selection)
+        {
+            if (range.left() != 0)
+                continue;    // only count each row once
+            for (int row = range.top(), end = range.bottom();  row <= end;  ++row)
+            {
+                const EventId id = model->eventId(model->index(row, 0, range.parent()));
+                if (!id.isEmpty())
+                    ids += id;
+            }
+        }
+    }
+    return ids;
+}
+
+/******************************************************************************
+* Return the number of selected events.
+*/
+int EventListView::selectedCount() const
+{
+    int count = 0;
+    const QItemSelection selection = selectionModel()->selection();
+    for (const QItemSelectionRange& range : selection)
+    {
+        if (range.left() == 0)
+            count += range.height();
+    }
+    return count;
+}
+
 /******************************************************************************
 * Called when the Find action is selected.
 * Display the non-modal Find dialog.
@@ -44,6 +44,8 @@ class EventListView : public QTreeView
         QModelIndex       selectedIndex() const;
         KAEvent           selectedEvent() const;
         QVector<KAEvent>  selectedEvents() const;
+        QVector<EventId>  selectedEventIds() const;
+        int               selectedCount() const;
         void              setEditOnSingleClick(bool e) { mEditOnSingleClick = e; }
         bool              editOnSingleClick() const    { return mEditOnSingleClick; }
 
@@ -288,21 +288,21 @@ UpdateResult addEvents(QVector<KAEvent>& events, QWidget* msgParent, bool allowK
     }
     if (status.status == UPDATE_OK)
     {
+        // Save the event details in the calendar in a single transaction,
+        // and get the new event IDs.
         AlarmCalendar* cal = AlarmCalendar::resources();
-        for (int i = 0, end = events.count();  i < end;  ++i)
+        if (!cal->addEvents(events, collection))
+            status.setError(UPDATE_ERROR, events.count());
+        else if (allowKOrgUpdate)
         {
-            // Save the event details in the calendar file, and get the new event ID
-            if (!cal->addEvent(events[i], msgParent, false, &collection))
-            {
-                status.setError(UPDATE_ERROR);
-                continue;
-            }
-            if (allowKOrgUpdate  &&  events[i].copyToKOrganizer())
+            for (int i = 0, end = events.count();  i < end;  ++i)
             {
-                UpdateResult st = sendToKOrganizer(events[i]);    // tell KOrganizer to show the event
-                status.korgUpdate(st);
+                if (events[i].copyToKOrganizer())
+                {
+                    UpdateResult st = sendToKOrganizer(events[i]);    // tell KOrganizer to show the event
+                    status.korgUpdate(st);
+                }
             }
-
         }
         if (status.warnErr == events.count())
             status.status = UPDATE_FAILED;
@@ -491,6 +491,16 @@ UpdateResult deleteEvent(KAEvent& event, bool archive, QWidget* msgParent, bool
 }
 
 UpdateResult deleteEvents(QVector<KAEvent>& events, bool archive, QWidget* msgParent, bool showKOrgErr)
+{
+    return deleteEvents(KAEvent::ptrList(events), archive, msgParent, showKOrgErr);
+}
+
+/******************************************************************************
+* Delete alarms, given pointers to them. The events may be the instances held
+* by the resources calendar, in which case they are deleted by this function
+* and the pointers become invalid.
+*/
+UpdateResult deleteEvents(const KAEvent::List& events, bool archive, QWidget* msgParent, bool showKOrgErr)
 {
     qCDebug(KALARM_LOG) << events.count();
     if (events.isEmpty())
@@ -502,8 +512,9 @@ UpdateResult deleteEvents(QVector<KAEvent>& events, bool archive, QWidget* msgPa
     for (int i = 0, end = events.count();  i < end;  ++i)
     {
         // Save the event details in the calendar file, and get the new event ID
-        KAEvent* event = &events[i];
-        QString id = event->id();
+        KAEvent* event = events[i];
+        const QString id = event->id();
+        const EventId eventId(*event);
 
 
         // Delete the event from the calendar file
@@ -525,12 +536,13 @@ UpdateResult deleteEvents(QVector<KAEvent>& events, bool archive, QWidget* msgPa
         }
         if (!cal->deleteEvent(*event, false))   // don't save calendar after deleting
             status.setError(UPDATE_ERROR);
+        // 'event' may now have been deleted
 
         if (id == wakeFromSuspendId)
             deleteWakeFromSuspendAlarm = true;
 
         // Remove "Don't show error messages again" for this alarm
-        setDontShowErrors(EventId(*event));
+        setDontShowErrors(eventId);
     }
 
     if (status.warnErr == events.count())
@@ -674,8 +686,10 @@ UpdateResult reactivateEvents(QVector<KAEvent>& events, QVector<EventId>& inelig
 /******************************************************************************
 * Enable or disable alarms in the calendar file and in every main window instance.
 * The new events will have the same event IDs as the old ones.
+* The events may be the instances held by the resources calendar. Only those
+* events whose enabled status actually changes are copied for updating.
 */
-UpdateResult enableEvents(QVector<KAEvent>& events, bool enable, QWidget* msgParent)
+UpdateResult enableEvents(const KAEvent::List& events, bool enable, QWidget* msgParent)
 {
     qCDebug(KALARM_LOG) << events.count();
     if (events.isEmpty())
@@ -686,27 +700,28 @@ UpdateResult enableEvents(QVector<KAEvent>& events, bool enable, QWidget* msgPar
     QString wakeFromSuspendId = checkRtcWakeConfig().value(0);
     for (int i = 0, end = events.count();  i < end;  ++i)
     {
-        KAEvent* event = &events[i];
+        const KAEvent* event = events[i];
         if (event->category() == CalEvent::ACTIVE
         &&  enable != event->enabled())
         {
-            event->setEnabled(enable);
+            KAEvent newEvent(*event);
+            newEvent.setEnabled(enable);
 
-            if (!enable  &&  event->id() == wakeFromSuspendId)
+            if (!enable  &&  newEvent.id() == wakeFromSuspendId)
                 deleteWakeFromSuspendAlarm = true;
 
             // Update the event in the calendar file
-            KAEvent* newev = cal->updateEvent(event);
+            KAEvent* newev = cal->updateEvent(newEvent);
             if (!newev)
-                qCCritical(KALARM_LOG) << "Error updating event in calendar:" << event->id();
+                qCCritical(KALARM_LOG) << "Error updating event in calendar:" << newEvent.id();
             else
             {
                 cal->disabledChanged(newev);
 
                 // If we're disabling a display alarm, close any message window
-                if (!enable  &&  (event->actionTypes() & KAEvent::ACT_DISPLAY))
+                if (!enable  &&  (newEvent.actionTypes() & KAEvent::ACT_DISPLAY))
                 {
-                    MessageWin* win = MessageWin::findEvent(EventId(*event));
+                    MessageWin* win = MessageWin::findEvent(EventId(newEvent));
                     delete win;
                 }
             }
@@ -1797,6 +1812,23 @@ QString conversionPrompt(const QString& calendarName, const QString& calendarVer
                  "<para>Do you wish to update the calendar?</para>", msg);
 }
 
+/******************************************************************************
+* Return a prompt string to ask the user whether to convert a number of
+* calendars to the current format.
+*/
+QString conversionPrompt(int calendarCount)
+{
+    const QString msg = xi18ncp("@info", "Some or all of the alarms in the following calendar are in an old <application>KAlarm</application> format, "
+                                "and will be read-only unless you choose to update them to the current format.",
+                                "Some or all of the alarms in the following %1 calendars are in an old <application>KAlarm</application> format, "
+                                "and will be read-only unless you choose to update them to the current format.",
+                                calendarCount);
+    return xi18nc("@info", "<para>%1</para><para>"
+                 "<warning>Do not update a calendar if it is also used with an older version of <application>KAlarm</application> "
+                 "(e.g. on another computer). If you do so, the calendar may become unusable there.</warning></para>"
+                 "<para>Do you wish to update the listed calendars?</para>", msg);
+}
+
 #ifndef NDEBUG
 /******************************************************************************
 * Set up KAlarm test conditions based on environment variables.
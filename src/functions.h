@@ -163,13 +163,14 @@ UpdateResult        updateEvent(KAEvent&, QWidget* msgParent = nullptr, bool arc
 UpdateResult        updateTemplate(KAEvent&, QWidget* msgParent = nullptr);
 UpdateResult        deleteEvent(KAEvent&, bool archive = true, QWidget* msgParent = nullptr, bool showKOrgErr = true);
 UpdateResult        deleteEvents(QVector<KAEvent>&, bool archive = true, QWidget* msgParent = nullptr, bool showKOrgErr = true);
+UpdateResult        deleteEvents(const KAEvent::List&, bool archive = true, QWidget* msgParent = nullptr, bool showKOrgErr = true);
 UpdateResult        deleteTemplates(const KAEvent::List& events, QWidget* msgParent = nullptr);
 inline UpdateResult deleteTemplate(KAEvent& event, QWidget* msgParent = nullptr)
                         { KAEvent::List e;  e += &event;  return deleteTemplates(e, msgParent); }
 void                deleteDisplayEvent(const QString& eventID);
 UpdateResult        reactivateEvent(KAEvent&, Akonadi::Collection* = nullptr, QWidget* msgParent = nullptr, bool showKOrgErr = true);
 UpdateResult        reactivateEvents(QVector<KAEvent>&, QVector<EventId>& ineligibleIDs, Akonadi::Collection* = nullptr, QWidget* msgParent = nullptr, bool showKOrgErr = true);
-UpdateResult        enableEvents(QVector<KAEvent>&, bool enable, QWidget* msgParent = nullptr);
+UpdateResult        enableEvents(const KAEvent::List&, bool enable, QWidget* msgParent = nullptr);
 QVector<KAEvent>    getSortedActiveEvents(QObject* parent, AlarmListModel** model = nullptr);
 void                purgeArchive(int purgeDays);    // must only be called from KAlarmApp::processQueue()
 void                displayKOrgUpdateError(QWidget* parent, UpdateError, UpdateResult korgError, int nAlarms = 0);
@@ -187,6 +188,12 @@ bool                setRtcWakeTime(unsigned triggerTime, QWidget* parent);
  */
 QString             conversionPrompt(const QString& calendarName, const QString& calendarVersion, bool whole);
 
+/** Return a prompt string to ask the user whether to convert a list of calendars
+ *  to the current format. The calendar names should be displayed separately.
+ *  @param calendarCount the number of calendars in the list.
+ */
+QString             conversionPrompt(int calendarCount);
+
 Akonadi::Collection invalidCollection();  // for use as a non-const default parameter
 
 #ifndef NDEBUG
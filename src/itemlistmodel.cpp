@@ -173,6 +173,14 @@ KAEvent ItemListModel::event(const QModelIndex& index) const
     return static_cast<AkonadiModel*>(sourceModel())->event(mapToSource(index));
 }
 
+/******************************************************************************
+* Return the ID of the event referred to by an index.
+*/
+EventId ItemListModel::eventId(const QModelIndex& index) const
+{
+    return static_cast<AkonadiModel*>(sourceModel())->eventId(mapToSource(index));
+}
+
 /******************************************************************************
 * Check whether the model contains any events.
 */
@@ -265,6 +273,11 @@ TemplateListModel::TemplateListModel(QObject* parent)
       mActionsEnabled(KAEvent::ACT_ALL),
       mActionsFilter(KAEvent::ACT_ALL)
 {
+    QAbstractItemModel* source = sourceModel();
+    connect(source, &QAbstractItemModel::rowsInserted, this, &TemplateListModel::slotSourceRowsInserted);
+    connect(source, &QAbstractItemModel::rowsAboutToBeRemoved, this, &TemplateListModel::slotSourceRowsAboutToBeRemoved);
+    connect(source, &QAbstractItemModel::modelReset, this, &TemplateListModel::slotSourceReset);
+    connect(source, &QAbstractItemModel::dataChanged, this, &TemplateListModel::slotSourceDataChanged);
 }
 
 TemplateListModel::~TemplateListModel()
@@ -303,13 +316,163 @@ void TemplateListModel::setAlarmActionsEnabled(KAEvent::Actions types)
     }
 }
 
+/******************************************************************************
+* Set the text which template names must contain.
+* While a filter is set, an index of the case folded names of all templates is
+* kept up to date, so that the source model, which also contains alarms, only
+* needs to be scanned when the filter is first set.
+* If the new text contains the old text, the templates which did not match the
+* old text can't match the new one, so only the previous matches are checked.
+* Otherwise, the index is checked.
+*/
+void TemplateListModel::setNameFilter(const QString& text)
+{
+    if (this == mAllInstance  ||  text == mNameFilterText)
+        return;
+    const QString folded = text.toCaseFolded();
+    const bool refine = !mNameFilter.isEmpty()  &&  folded.contains(mNameFilter);
+    const bool indexed = !mNameFilter.isEmpty();
+    mNameFilterText = text;
+    mNameFilter = folded;
+    if (mNameFilter.isEmpty())
+    {
+        // Release the index, so that source model changes cost nothing
+        mNameMatches.clear();
+        mTemplateNames.clear();
+    }
+    else if (!indexed)
+        buildNameIndex();
+    else if (refine)
+    {
+        for (QHash<Item::Id, QString>::iterator it = mNameMatches.begin();  it != mNameMatches.end();  )
+        {
+            if (it.value().contains(mNameFilter))
+                ++it;
+            else
+                it = mNameMatches.erase(it);
+        }
+    }
+    else
+        findNameMatches();
+    invalidateFilter();
+}
+
+/******************************************************************************
+* Build the index of template names by scanning the whole source model, and
+* find the templates whose names match the name filter.
+*/
+void TemplateListModel::buildNameIndex()
+{
+    mTemplateNames.clear();
+    mNameMatches.clear();
+    indexRows(0, sourceModel()->rowCount() - 1);
+}
+
+/******************************************************************************
+* Find all templates in the name index whose names match the name filter.
+*/
+void TemplateListModel::findNameMatches()
+{
+    mNameMatches.clear();
+    for (QHash<Item::Id, QString>::const_iterator it = mTemplateNames.constBegin();  it != mTemplateNames.constEnd();  ++it)
+    {
+        if (it.value().contains(mNameFilter))
+            mNameMatches.insert(it.key(), it.value());
+    }
+}
+
+/******************************************************************************
+* Update the name index and the list of matches for a range of source model
+* rows. Rows which are not templates in enabled collections are skipped
+* without fetching their names.
+*/
+void TemplateListModel::indexRows(int first, int last)
+{
+    const QAbstractItemModel* source = sourceModel();
+    for (int row = first;  row <= last;  ++row)
+    {
+        if (!ItemListModel::filterAcceptsRow(row, QModelIndex()))
+            continue;
+        const QModelIndex ix = source->index(row, AkonadiModel::TemplateNameColumn);
+        const Item::Id id = ix.data(AkonadiModel::ItemIdRole).toLongLong();
+        const QString name = ix.data(Qt::DisplayRole).toString().toCaseFolded();
+        mTemplateNames.insert(id, name);
+        if (name.contains(mNameFilter))
+            mNameMatches.insert(id, name);
+        else
+            mNameMatches.remove(id);
+    }
+}
+
+/******************************************************************************
+* Called when rows are added to the source model.
+* Add any new templates to the name index.
+*/
+void TemplateListModel::slotSourceRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (!mNameFilter.isEmpty()  &&  !parent.isValid())
+    {
+        indexRows(first, last);
+        invalidateFilter();
+    }
+}
+
+/******************************************************************************
+* Called when rows are about to be removed from the source model.
+* Remove them from the name index.
+*/
+void TemplateListModel::slotSourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (mNameFilter.isEmpty()  ||  parent.isValid())
+        return;
+    const QAbstractItemModel* source = sourceModel();
+    for (int row = first;  row <= last;  ++row)
+    {
+        const Item::Id id = source->index(row, 0).data(AkonadiModel::ItemIdRole).toLongLong();
+        mTemplateNames.remove(id);
+        mNameMatches.remove(id);
+    }
+}
+
+/******************************************************************************
+* Called when the source model has been reset.
+* Rebuild the name index.
+*/
+void TemplateListModel::slotSourceReset()
+{
+    if (!mNameFilter.isEmpty())
+    {
+        buildNameIndex();
+        invalidateFilter();
+    }
+}
+
+/******************************************************************************
+* Called when data in the source model has changed.
+* If template names may have changed, update the name index for the changed
+* rows.
+*/
+void TemplateListModel::slotSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    if (!mNameFilter.isEmpty()  &&  !topLeft.parent().isValid()
+    &&  topLeft.column() <= AkonadiModel::TemplateNameColumn
+    &&  bottomRight.column() >= AkonadiModel::TemplateNameColumn)
+    {
+        indexRows(topLeft.row(), bottomRight.row());
+        invalidateFilter();
+    }
+}
+
 bool TemplateListModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
     if (!ItemListModel::filterAcceptsRow(sourceRow, sourceParent))
         return false;
+    QModelIndex sourceIndex = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (!mNameFilter.isEmpty()
+    &&  !mNameMatches.contains(sourceIndex.data(AkonadiModel::ItemIdRole).toLongLong()))
+        return false;
     if (mActionsFilter == KAEvent::ACT_ALL)
         return true;
-    QModelIndex sourceIndex = sourceModel()->index(sourceRow, 0, sourceParent);
     KAEvent::Actions actions = static_cast<KAEvent::Actions>(sourceModel()->data(sourceIndex, AkonadiModel::AlarmActionsRole).toInt());
     return actions & mActionsFilter;
 }
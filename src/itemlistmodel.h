@@ -28,6 +28,8 @@
 
 #include <AkonadiCore/entitymimetypefiltermodel.h>
 
+#include <QHash>
+
 using namespace KAlarmCal;
 
 /*=============================================================================
@@ -48,6 +50,7 @@ class ItemListModel : public Akonadi::EntityMimeTypeFilterModel
         KAEvent      event(int row) const;
         KAEvent      event(const QModelIndex&) const;
         using QObject::event;   // prevent warning about hidden virtual method
+        EventId      eventId(const QModelIndex&) const;
         QModelIndex  eventIndex(Akonadi::Item::Id) const;
 
         /** Determine whether the model contains any items. */
@@ -157,6 +160,18 @@ class TemplateListModel : public ItemListModel
         /** Set which alarm types should be shown as disabled in the model. */
         KAEvent::Actions setAlarmActionsEnabled() const  { return mActionsEnabled; }
 
+        /** Set a filter to include only templates whose names contain a given
+         *  text, ignoring case. If the text extends the previous filter text,
+         *  only the templates which matched the previous filter are checked.
+         *  While a filter is set, an index of template names is maintained, so
+         *  the filter should be cleared when it is no longer needed.
+         *  @param text the text to match, or empty to include all templates
+         */
+        void setNameFilter(const QString& text);
+
+        /** Return the text set by setNameFilter(). */
+        QString nameFilter() const  { return mNameFilterText; }
+
         int  columnCount(const QModelIndex& = QModelIndex()) const override  { return ColumnCount; }
         QVariant headerData(int section, Qt::Orientation, int role = Qt::DisplayRole) const override;
         Qt::ItemFlags flags(const QModelIndex&) const override;
@@ -165,11 +180,25 @@ class TemplateListModel : public ItemListModel
         bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
         bool filterAcceptsColumn(int sourceCol, const QModelIndex& sourceParent) const override;
 
+    private Q_SLOTS:
+        void slotSourceRowsInserted(const QModelIndex& parent, int first, int last);
+        void slotSourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+        void slotSourceReset();
+        void slotSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+
     private:
+        void buildNameIndex();
+        void findNameMatches();
+        void indexRows(int first, int last);
+
         static TemplateListModel* mAllInstance;
 
         KAEvent::Actions mActionsEnabled;  // disable types not in this mask
         KAEvent::Actions mActionsFilter;   // hide types not in this mask
+        QString          mNameFilterText;  // text set by setNameFilter()
+        QString          mNameFilter;      // case folded name filter text
+        QHash<Akonadi::Item::Id, QString> mTemplateNames;  // case folded names of all templates, while mNameFilter is set
+        QHash<Akonadi::Item::Id, QString> mNameMatches;    // templates matching mNameFilter, with case folded names
 };
 
 #endif // ITEMLISTMODEL_H
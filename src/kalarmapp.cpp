@@ -22,6 +22,7 @@
 #include "kalarmapp.h"
 
 #include "alarmcalendar.h"
+#include "alarminbox.h"
 #include "alarmlistview.h"
 #include "alarmtime.h"
 #include "commandoptions.h"
@@ -73,6 +74,7 @@
 #include <climits>
 
 static const int AKONADI_TIMEOUT = 30;   // timeout (seconds) for Akonadi collections to be populated
+static const int MESSAGE_PREPARE_SECS = 5;   // seconds before trigger time to prepare message windows
 
 /******************************************************************************
 * Find the maximum number of seconds late which a late-cancel alarm is allowed
@@ -421,46 +423,87 @@ int KAlarmApp::activateInstance(const QStringList& args, const QString& workingD
             {
                 // Display or delete the event with the specified event ID
                 EventFunc function = (command == CommandOptions::TRIGGER_EVENT) ? EVENT_TRIGGER : EVENT_CANCEL;
-                // Open the calendar, don't start processing execution queue yet,
-                // and wait for the Akonadi collection to be populated.
-                if (!initCheck(true, true, options->eventId().collectionId()))
+                // Open the calendar, don't start processing execution queue yet.
+                if (!initCheck(true))
                     exitCode = 1;
                 else
                 {
-                    startProcessQueue();      // start processing the execution queue
                     dontRedisplay = true;
-                    if (!handleEvent(options->eventId(), function, true))
-                    {
-                        CommandOptions::printError(xi18nc("@info:shell", "%1: Event <resource>%2</resource> not found, or not unique", QStringLiteral("--") + options->commandName(), options->eventId().eventId()));
-                        exitCode = 1;
-                    }
+                    // Handle the event once the Akonadi collection has been populated.
+                    const EventId eventId = options->eventId();
+                    const QString commandName = options->commandName();
+                    ++mActiveCount;    // prevent the application from quitting while waiting
+                    CollectionControlModel::instance()->whenPopulated(eventId.collectionId(), AKONADI_TIMEOUT, this,
+                        [this, eventId, commandName, function](bool populated)
+                        {
+                            int code = 0;
+                            if (!populated)
+                                code = 1;
+                            else
+                            {
+                                startProcessQueue();      // start processing the execution queue
+                                if (!handleEvent(eventId, function, true))
+                                {
+                                    CommandOptions::printError(xi18nc("@info:shell", "%1: Event <resource>%2</resource> not found, or not unique", QStringLiteral("--") + commandName, eventId.eventId()));
+                                    code = 1;
+                                }
+                            }
+                            --mActiveCount;
+                            quitIf(code);
+                        });
                 }
                 break;
             }
             case CommandOptions::LIST:
                 // Output a list of scheduled alarms to stdout.
-                // Open the calendar, don't start processing execution queue yet,
-                // and wait for all Akonadi collections to be populated.
+                // Open the calendar, don't start processing execution queue yet.
                 mReadOnly = true;   // don't need write access to calendars
-                if (!initCheck(true, true))
+                if (!initCheck(true))
                     exitCode = 1;
                 else
                 {
                     dontRedisplay = true;
-                    QStringList alarms = scheduledAlarmList();
-                    for (int i = 0, count = alarms.count();  i < count;  ++i)
-                        std::cout << alarms[i].toUtf8().constData() << std::endl;
+                    // Output the list once all Akonadi collections have been populated.
+                    ++mActiveCount;    // prevent the application from quitting while waiting
+                    CollectionControlModel::instance()->whenPopulated(-1, AKONADI_TIMEOUT, this,
+                        [this](bool populated)
+                        {
+                            if (populated)
+                            {
+                                const QStringList alarms = scheduledAlarmList();
+                                for (int i = 0, count = alarms.count();  i < count;  ++i)
+                                    std::cout << alarms[i].toUtf8().constData() << std::endl;
+                            }
+                            --mActiveCount;
+                            quitIf(populated ? 0 : 1);
+                        });
                 }
                 break;
             case CommandOptions::EDIT:
                 // Edit a specified existing alarm.
-                // Open the calendar and wait for the Akonadi collection to be populated.
-                if (!initCheck(false, true, options->eventId().collectionId()))
+                // Open the calendar, and edit the alarm once the Akonadi
+                // collection has been populated.
+                if (!initCheck())
                     exitCode = 1;
-                else if (!KAlarm::editAlarmById(options->eventId()))
+                else
                 {
-                    CommandOptions::printError(xi18nc("@info:shell", "%1: Event <resource>%2</resource> not found, or not editable", QStringLiteral("--") + options->commandName(), options->eventId().eventId()));
-                    exitCode = 1;
+                    const EventId eventId = options->eventId();
+                    const QString commandName = options->commandName();
+                    ++mActiveCount;    // prevent the application from quitting while waiting
+                    CollectionControlModel::instance()->whenPopulated(eventId.collectionId(), AKONADI_TIMEOUT, this,
+                        [this, eventId, commandName](bool populated)
+                        {
+                            int code = 0;
+                            if (!populated)
+                                code = 1;
+                            else if (!KAlarm::editAlarmById(eventId))
+                            {
+                                CommandOptions::printError(xi18nc("@info:shell", "%1: Event <resource>%2</resource> not found, or not editable", QStringLiteral("--") + commandName, eventId.eventId()));
+                                code = 1;
+                            }
+                            --mActiveCount;
+                            quitIf(code);
+                        });
                 }
                 break;
 
@@ -674,7 +717,7 @@ bool KAlarmApp::quitIf(int exitCode, bool force)
         MainWindow::closeAll();
         mQuitting = false;
         displayTrayIcon(false);
-        if (MessageWin::instanceCount(true))    // ignore always-hidden windows (e.g. audio alarms)
+        if (MessageWin::instanceCount(true)  ||  AlarmInbox::count())    // ignore always-hidden windows (e.g. audio alarms)
             return false;
     }
     else if (mQuitting)
@@ -683,7 +726,7 @@ bool KAlarmApp::quitIf(int exitCode, bool force)
     {
         // Quit only if there are no more "instances" running
         mPendingQuit = false;
-        if (mActiveCount > 0  ||  MessageWin::instanceCount(true))  // ignore always-hidden windows (e.g. audio alarms)
+        if (mActiveCount > 0  ||  MessageWin::instanceCount(true)  ||  AlarmInbox::count())  // ignore always-hidden windows (e.g. audio alarms)
             return false;
         int mwcount = MainWindow::count();
         MainWindow* mw = mwcount ? MainWindow::firstWindow() : nullptr;
@@ -721,6 +764,7 @@ bool KAlarmApp::quitIf(int exitCode, bool force)
     delete mAlarmTimer;     // prevent checking for alarms after deleting calendars
     mAlarmTimer = nullptr;
     mInitialised = false;   // prevent processQueue() from running
+    AkonadiModel::instance()->flushCommandErrors();   // save any pending command error statuses
     AlarmCalendar::terminateCalendars();
     exit(exitCode);
     return true;    // sometimes we actually get to here, despite calling exit()
@@ -843,6 +887,17 @@ void KAlarmApp::checkNextDueAlarm()
     }
     else
     {
+        if (interval <= MESSAGE_PREPARE_SECS)
+        {
+            // The alarm is due very soon. Prepare its message window now, so
+            // that it can be displayed without delay when the alarm triggers.
+            MessageWin::prepare(*nextEvent);
+        }
+        else
+        {
+            // Wake up in time to prepare the alarm's message window.
+            interval -= MESSAGE_PREPARE_SECS;
+        }
         // No alarm is due yet, so set timer to wake us when it's due.
         // Check for integer overflow before setting timer.
 #ifndef HIBERNATION_SIGNAL
@@ -1318,7 +1373,10 @@ void KAlarmApp::setAlarmsEnabled(bool enabled)
         mAlarmsEnabled = enabled;
         Q_EMIT alarmEnabledToggled(enabled);
         if (!enabled)
+        {
             KAlarm::cancelRtcWake(nullptr);
+            MessageWin::discardPrepared();
+        }
         else if (!mProcessingQueue)
             checkNextDueAlarm();
     }
@@ -1913,7 +1971,7 @@ void* KAlarmApp::execAlarm(KAEvent& event, const KAAlarm& alarm, bool reschedule
                 for (int i = 0, end = mCommandProcesses.count();  i < end;  ++i)
                 {
                     ProcData* pd = mCommandProcesses[i];
-                    if (pd->event->id() == event.id()  &&  (pd->flags & ProcData::PRE_ACTION))
+                    if (pd->event->id() == event.id()  &&  pd->preAction()  &&  !pd->timedOut())
                     {
                         qCDebug(KALARM_LOG) << "Already executing pre-DISPLAY command";
                         return pd->process;   // already executing - don't duplicate the action
@@ -1925,9 +1983,23 @@ void* KAlarmApp::execAlarm(KAEvent& event, const KAAlarm& alarm, bool reschedule
                 QString command = event.preAction();
                 qCDebug(KALARM_LOG) << "Pre-DISPLAY command:" << command;
                 int flags = (reschedule ? ProcData::RESCHEDULE : 0) | (allowDefer ? ProcData::ALLOW_DEFER : 0);
-                if (doShellCommand(command, event, &alarm, (flags | ProcData::PRE_ACTION)))
+                ShellProcess* proc = doShellCommand(command, event, &alarm, (flags | ProcData::PRE_ACTION));
+                if (proc)
                 {
                     AlarmCalendar::resources()->setAlarmPending(&event);
+                    // Show the alarm straight away, together with the pre-action's
+                    // output, until the message can be displayed.
+                    if (!win  &&  !AlarmInbox::contains(EventId(event))  &&  !AlarmInbox::wanted(alarm))
+                        MessageWin::showPreAction(event, alarm, proc);
+                    const int timeout = Preferences::preActionTimeout();
+                    if (timeout > 0)
+                    {
+                        // Don't wait indefinitely for the command to complete
+                        QTimer* timer = new QTimer(proc);
+                        timer->setSingleShot(true);
+                        connect(timer, &QTimer::timeout, this, &KAlarmApp::slotPreActionTimeout);
+                        timer->start(timeout * 1000);
+                    }
                     return result;     // display the message after the command completes
                 }
                 // Error executing command
@@ -1942,11 +2014,20 @@ void* KAlarmApp::execAlarm(KAEvent& event, const KAAlarm& alarm, bool reschedule
                 // Display the message even though it failed
             }
 
-            if (!win)
+            if (!win  &&  (AlarmInbox::contains(EventId(event))  ||  AlarmInbox::wanted(alarm)))
+            {
+                // Show the alarm in the alarm inbox instead of in a message window
+                int flags = (reschedule ? 0 : MessageWin::NO_RESCHEDULE) | (allowDefer ? 0 : MessageWin::NO_DEFER);
+                AlarmInbox::addAlarm(event, alarm, flags);
+            }
+            else if (!win)
             {
                 // There isn't already a message for this event
                 int flags = (reschedule ? 0 : MessageWin::NO_RESCHEDULE) | (allowDefer ? 0 : MessageWin::NO_DEFER);
-                (new MessageWin(&event, alarm, flags))->show();
+                MessageWin* newWin = MessageWin::takePrepared(event, alarm, flags);
+                if (!newWin)
+                    newWin = new MessageWin(&event, alarm, flags);
+                newWin->show();
             }
             else if (replaceReminder)
             {
@@ -2259,7 +2340,10 @@ void KAlarmApp::slotCommandExited(ShellProcess* proc)
         if (pd->process == proc)
         {
             // Found the command. Check its exit status.
-            bool executeAlarm = pd->preAction();
+            // If a pre-action timed out, the alarm has already been displayed.
+            bool executeAlarm = pd->preAction()  &&  !pd->timedOut();
+            if (pd->preAction()  &&  !pd->timedOut())
+                MessageWin::endPreAction(EventId(*pd->event));
             ShellProcess::Status status = proc->status();
             if (status == ShellProcess::SUCCESS  &&  !proc->exitCode())
             {
@@ -2303,7 +2387,7 @@ void KAlarmApp::slotCommandExited(ShellProcess* proc)
                     executeAlarm = false;
                 }
             }
-            if (pd->preAction())
+            if (pd->preAction()  &&  !pd->timedOut())
                 AlarmCalendar::resources()->setAlarmPending(pd->event, false);
             if (executeAlarm)
                 execAlarm(*pd->event, *pd->alarm, pd->reschedule(), pd->allowDefer(), true);
@@ -2318,6 +2402,31 @@ void KAlarmApp::slotCommandExited(ShellProcess* proc)
         quitIf(mPendingQuitCode);
 }
 
+/******************************************************************************
+* Called when a pre-alarm action has not completed within the configured time.
+* Display the alarm without waiting any longer for the command. The command is
+* left to run, but its completion no longer affects the alarm.
+*/
+void KAlarmApp::slotPreActionTimeout()
+{
+    const ShellProcess* proc = qobject_cast<ShellProcess*>(sender()->parent());
+    for (int i = 0, end = mCommandProcesses.count();  i < end;  ++i)
+    {
+        ProcData* pd = mCommandProcesses[i];
+        if (pd->process == proc)
+        {
+            if (!pd->preAction()  ||  pd->timedOut())
+                return;
+            qCWarning(KALARM_LOG) << pd->event->id() << ": pre-action timed out: displaying alarm";
+            pd->flags |= ProcData::TIMED_OUT;
+            MessageWin::endPreAction(EventId(*pd->event));
+            AlarmCalendar::resources()->setAlarmPending(pd->event, false);
+            execAlarm(*pd->event, *pd->alarm, pd->reschedule(), pd->allowDefer(), true);
+            return;
+        }
+    }
+}
+
 /******************************************************************************
 * Output an error message for a shell command, and record the alarm's error status.
 */
@@ -2381,7 +2490,7 @@ void KAlarmApp::commandMessage(ShellProcess* proc, QWidget* parent)
 * If this is the first time through, open the calendar file, and start
 * processing the execution queue.
 */
-bool KAlarmApp::initCheck(bool calendarOnly, bool waitForCollection, Akonadi::Collection::Id collectionId)
+bool KAlarmApp::initCheck(bool calendarOnly)
 {
     static bool firstTime = true;
     if (firstTime)
@@ -2411,13 +2520,6 @@ bool KAlarmApp::initCheck(bool calendarOnly, bool waitForCollection, Akonadi::Co
 
     if (!calendarOnly)
         startProcessQueue();      // start processing the execution queue
-
-    if (waitForCollection)
-    {
-        // Wait for one or all Akonadi collections to be populated
-        if (!CollectionControlModel::instance()->waitUntilPopulated(collectionId, AKONADI_TIMEOUT))
-            return false;
-    }
     return true;
 }
 
@@ -2448,9 +2550,12 @@ void KAlarmApp::setEventCommandError(const KAEvent& event, KAEvent::CmdErrType e
 
     if (err == KAEvent::CMD_ERROR_POST  &&  event.commandError() == KAEvent::CMD_ERROR_PRE)
         err = KAEvent::CMD_ERROR_PRE_POST;
-    event.setCommandError(err);
     KAEvent* ev = AlarmCalendar::resources()->event(EventId(event));
-    if (ev  &&  ev->commandError() != err)
+    const KAEvent::CmdErrType olderr = ev ? ev->commandError() : event.commandError();
+    event.setCommandError(err);
+    if (olderr == err)
+        return;   // no change, so don't update the calendar
+    if (ev)
         ev->setCommandError(err);
     AkonadiModel::instance()->updateCommandError(event);
 }
@@ -2464,14 +2569,14 @@ void KAlarmApp::clearEventCommandError(const KAEvent& event, KAEvent::CmdErrType
     if (pd && pd->eventDeleted)
         return;   // the alarm has been deleted, so can't set error status
 
-    KAEvent::CmdErrType newerr = static_cast<KAEvent::CmdErrType>(event.commandError() & ~err);
-    event.setCommandError(newerr);
     KAEvent* ev = AlarmCalendar::resources()->event(EventId(event));
+    const KAEvent::CmdErrType olderr = ev ? ev->commandError() : event.commandError();
+    const KAEvent::CmdErrType newerr = static_cast<KAEvent::CmdErrType>(olderr & ~err);
+    event.setCommandError(static_cast<KAEvent::CmdErrType>(event.commandError() & ~err));
+    if (newerr == olderr)
+        return;   // no change (the usual case), so don't update the calendar
     if (ev)
-    {
-        newerr = static_cast<KAEvent::CmdErrType>(ev->commandError() & ~err);
         ev->setCommandError(newerr);
-    }
     AkonadiModel::instance()->updateCommandError(event);
 }
 
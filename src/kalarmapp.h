@@ -129,6 +129,7 @@ class KAlarmApp : public QApplication
         void               slotPurge()                     { purge(mArchivedPurgeDays); }
         void               purgeAfterDelay();
         void               slotCommandExited(ShellProcess*);
+        void               slotPreActionTimeout();
 
     private:
         enum EventFunc
@@ -142,7 +143,7 @@ class KAlarmApp : public QApplication
             ProcData(ShellProcess*, KAEvent*, KAAlarm*, int flags = 0);
             ~ProcData();
             enum { PRE_ACTION = 0x01, POST_ACTION = 0x02, RESCHEDULE = 0x04, ALLOW_DEFER = 0x08,
-                   TEMP_FILE = 0x10, EXEC_IN_XTERM = 0x20, DISP_OUTPUT = 0x40 };
+                   TEMP_FILE = 0x10, EXEC_IN_XTERM = 0x20, DISP_OUTPUT = 0x40, TIMED_OUT = 0x80 };
             bool  preAction() const   { return flags & PRE_ACTION; }
             bool  postAction() const  { return flags & POST_ACTION; }
             bool  reschedule() const  { return flags & RESCHEDULE; }
@@ -150,6 +151,7 @@ class KAlarmApp : public QApplication
             bool  tempFile() const    { return flags & TEMP_FILE; }
             bool  execInXterm() const { return flags & EXEC_IN_XTERM; }
             bool  dispOutput() const  { return flags & DISP_OUTPUT; }
+            bool  timedOut() const    { return flags & TIMED_OUT; }
             ShellProcess*     process;
             KAEvent*          event;
             KAAlarm*          alarm;
@@ -171,7 +173,7 @@ class KAlarmApp : public QApplication
         KAlarmApp(int& argc, char** argv);
         bool               initialise();
         int                activateInstance(const QStringList& args, const QString& workingDirectory, QString* outputText);
-        bool               initCheck(bool calendarOnly = false, bool waitForCollection = false, Akonadi::Collection::Id = -1);
+        bool               initCheck(bool calendarOnly = false);
         bool               quitIf(int exitCode, bool force = false);
         bool               checkSystemTray();
         void               startProcessQueue();
@@ -33,6 +33,12 @@
 #include <mailtransport/transportmanager.h>
 #include <mailtransport/transport.h>
 #include <mailtransportakonadi/messagequeuejob.h>
+#include <AkonadiCore/item.h>
+#include <AkonadiCore/itemcreatejob.h>
+#include <AkonadiCore/transactionsequence.h>
+#include <Akonadi/KMime/MessageFlags>
+#include <Akonadi/KMime/SpecialMailCollections>
+#include <Akonadi/KMime/SpecialMailCollectionsRequestJob>
 #include <KCalCore/Person>
 #include <kmime/kmime_header_parsing.h>
 #include <kmime/kmime_headers.h>
@@ -48,7 +54,6 @@
 #include <kemailsettings.h>
 #include <kcodecs.h>
 #include <kcharsets.h>
-#include <kshell.h>
 
 #include <QUrl>
 #include <QFile>
@@ -57,6 +62,7 @@
 #include <QByteArray>
 #include <QTextCodec>
 #include <QStandardPaths>
+#include <QTimer>
 #include <QtDBus/QtDBus>
 #include "kalarm_debug.h"
 
@@ -86,9 +92,29 @@ QString KAMail::i18n_NeedFromEmailAddress()
 QString KAMail::i18n_sent_mail()
 { return i18nc("@info KMail folder name: this should be translated the same as in kmail", "sent-mail"); }
 
+// Maximum number of emails being delivered concurrently by each local mail program
+static const int MAX_SENDMAIL_PROCESSES = 2;
+// Delay (milliseconds) before copying sent emails to the sent-mail folder, to allow them to be batched
+static const int SENT_COPY_DELAY = 2000;
+// Maximum number of sent emails to copy to the sent-mail folder in one transaction
+static const int SENT_COPY_BATCH = 50;
+
 KAMail*                              KAMail::mInstance = nullptr;   // used only to enable signals/slots to work
 QQueue<MailTransport::MessageQueueJob*> KAMail::mJobs;
 QQueue<KAMail::JobData>                 KAMail::mJobData;
+bool                                    KAMail::mEnvironmentInitialised = false;
+bool                                    KAMail::mAddressesCached = false;
+QString                                 KAMail::mFromAddress;
+QString                                 KAMail::mBccAddress;
+QString                                 KAMail::mHostName;
+QHash<int, QPointer<MailTransport::Transport> > KAMail::mTransports;
+QHash<QString, bool>                    KAMail::mNonLocalAddresses;
+QHash<QString, QString>                 KAMail::mMailPrograms;
+QQueue<KAMail::SendmailJob>             KAMail::mSendmailJobs;
+QHash<QProcess*, KAMail::SendmailProcess> KAMail::mSendmailProcesses;
+QList<KMime::Message::Ptr>              KAMail::mSentCopies;
+QList<KMime::Message::Ptr>              KAMail::mSentCopyBatch;
+QTimer*                                 KAMail::mSentCopyTimer = nullptr;
 
 KAMail* KAMail::instance()
 {
@@ -105,9 +131,10 @@ KAMail* KAMail::instance()
 */
 int KAMail::send(JobData& jobdata, QStringList& errmsgs)
 {
+    initEnvironment();
     QString err;
     KIdentityManagement::Identity identity;
-    jobdata.from = Preferences::emailAddress();
+    jobdata.from = fromAddress();
     if (jobdata.event.emailFromId()
     &&  Preferences::emailFrom() == Preferences::MAIL_FROM_KMAIL)
     {
@@ -146,48 +173,38 @@ int KAMail::send(JobData& jobdata, QStringList& errmsgs)
         }
         return -1;
     }
-    jobdata.bcc  = (jobdata.event.emailBcc() ? Preferences::emailBccAddress() : QString());
+    jobdata.bcc  = (jobdata.event.emailBcc() ? bccAddress() : QString());
     qCDebug(KALARM_LOG) << "To:" << jobdata.event.emailAddresses(QStringLiteral(","))
                   << endl << "Subject:" << jobdata.event.emailSubject();
 
     KMime::Message::Ptr message = KMime::Message::Ptr(new KMime::Message);
 
-    MailTransport::TransportManager* manager = MailTransport::TransportManager::self();
     MailTransport::Transport* transport = nullptr;
     if (Preferences::emailClient() == Preferences::sendmail)
     {
         qCDebug(KALARM_LOG) << "Sending via sendmail";
-        QStringList paths;
-        paths << QStringLiteral("/sbin") << QStringLiteral("/usr/sbin") << QStringLiteral("/usr/lib");
-        QString command = QStandardPaths::findExecutable(QStringLiteral("sendmail"), paths);
-        if (!command.isNull())
+        SendmailJob job;
+        job.program = mailProgram(QStringLiteral("sendmail"));
+        if (!job.program.isEmpty())
         {
-            command += QStringLiteral(" -f ");
-            command += extractEmailAndNormalize(jobdata.from);
-            command += QStringLiteral(" -oi -t ");
+            job.args << QStringLiteral("-f") << extractEmailAndNormalize(jobdata.from)
+                     << QStringLiteral("-oi") << QStringLiteral("-t");
             initHeaders(*message, jobdata);
         }
         else
         {
-            command = QStandardPaths::findExecutable(QStringLiteral("mail"), paths);
-            if (command.isNull())
+            job.program = mailProgram(QStringLiteral("mail"));
+            if (job.program.isEmpty())
             {
                 qCCritical(KALARM_LOG) << "sendmail not found";
                 errmsgs = errors(xi18nc("@info", "<command>%1</command> not found", QStringLiteral("sendmail"))); // give up
                 return -1;
             }
 
-            command += QStringLiteral(" -s ");
-            command += KShell::quoteArg(jobdata.event.emailSubject());
-
+            job.args << QStringLiteral("-s") << jobdata.event.emailSubject();
             if (!jobdata.bcc.isEmpty())
-            {
-                command += QStringLiteral(" -b ");
-                command += extractEmailAndNormalize(jobdata.bcc);
-            }
-
-            command += QLatin1Char(' ');
-            command += jobdata.event.emailPureAddresses(QStringLiteral(" ")); // locally provided, okay
+                job.args << QStringLiteral("-b") << extractEmailAndNormalize(jobdata.bcc);
+            job.args += jobdata.event.emailPureAddresses();
         }
         // Add the body and attachments to the message.
         // (Sendmail requires attachments to have already been included in the message.)
@@ -199,39 +216,21 @@ int KAMail::send(JobData& jobdata, QStringList& errmsgs)
             return -1;
         }
 
-        // Execute the send command
-        FILE* fd = ::popen(command.toLocal8Bit(), "w");
-        if (!fd)
-        {
-            qCCritical(KALARM_LOG) << "Unable to open a pipe to " << command;
-            errmsgs = errors();
-            return -1;
-        }
+        // Queue the message for delivery by the mail program. The result is
+        // notified by sendmailDone() once the mail program has terminated.
         message->assemble();
-        QByteArray encoded = message->encodedContent();
-        fwrite(encoded, encoded.length(), 1, fd);
-        pclose(fd);
-
-#ifdef KMAIL_SUPPORTED
+        job.message = message->encodedContent();
         if (Preferences::emailCopyToKMail())
-        {
-            // Create a copy of the sent email in KMail's 'sent-mail' folder,
-            // or if there was a send error, in KMail's 'outbox' folder.
-            err = addToKMailFolder(jobdata, "sent-mail", true);
-            if (!err.isNull())
-                errmsgs += errors(err, COPY_ERROR);    // not a fatal error - continue
-        }
-#endif
-
-        if (jobdata.allowNotify)
-            notifyQueued(jobdata.event);
-        return 1;
+            job.sentCopy = message;
+        job.data = jobdata;
+        mSendmailJobs.enqueue(job);
+        startSendmailJobs();
     }
     else
     {
         qCDebug(KALARM_LOG) << "Sending via KDE";
         const int transportId = identity.transport().isEmpty() ? -1 : identity.transport().toInt();
-        transport = manager->transportById(transportId, true);
+        transport = KAMail::transport(transportId);
         if (!transport)
         {
             qCCritical(KALARM_LOG) << "No mail transport found for identity" << identity.identityName() << "uoid" << identity.uoid();
@@ -314,6 +313,297 @@ void KAMail::slotEmailSent(KJob* job)
     }
 }
 
+/******************************************************************************
+* Set up notification of changes which affect the cached mail environment.
+*/
+void KAMail::initEnvironment()
+{
+    if (mEnvironmentInitialised)
+        return;
+    mEnvironmentInitialised = true;
+    KAMail* kamail = instance();
+    connect(Preferences::self(), &KCoreConfigSkeleton::configChanged, kamail, &KAMail::slotEnvironmentChanged);
+    connect(Identities::identityManager(), SIGNAL(changed()), kamail, SLOT(slotEnvironmentChanged()));
+    connect(MailTransport::TransportManager::self(), &MailTransport::TransportManager::transportsChanged, kamail, &KAMail::slotEnvironmentChanged);
+}
+
+/******************************************************************************
+* Called when the preferences, email identities or mail transports have changed.
+*/
+void KAMail::slotEnvironmentChanged()
+{
+    clearEnvironment();
+}
+
+/******************************************************************************
+* Clear the cached mail environment, so that it is fetched afresh when next
+* required.
+*/
+void KAMail::clearEnvironment()
+{
+    qCDebug(KALARM_LOG);
+    mAddressesCached = false;
+    mFromAddress.clear();
+    mBccAddress.clear();
+    mHostName.clear();
+    mTransports.clear();
+    mNonLocalAddresses.clear();
+    mMailPrograms.clear();
+}
+
+/******************************************************************************
+* Return the default 'From' email address.
+*/
+QString KAMail::fromAddress()
+{
+    if (!mAddressesCached)
+    {
+        mFromAddress = Preferences::emailAddress();
+        mBccAddress  = Preferences::emailBccAddress();
+        // System settings can change without notification, so don't cache them
+        mAddressesCached = (Preferences::emailFrom() != Preferences::MAIL_FROM_SYS_SETTINGS
+                        &&  Preferences::emailBccFrom() != Preferences::MAIL_FROM_SYS_SETTINGS);
+    }
+    return mFromAddress;
+}
+
+/******************************************************************************
+* Return the default 'Bcc' email address.
+*/
+QString KAMail::bccAddress()
+{
+    fromAddress();    // ensure the addresses are cached
+    return mBccAddress;
+}
+
+/******************************************************************************
+* Return the mail transport with a given ID, or the default transport if -1.
+*/
+MailTransport::Transport* KAMail::transport(int id)
+{
+    QHash<int, QPointer<MailTransport::Transport> >::const_iterator it = mTransports.constFind(id);
+    if (it != mTransports.constEnd()  &&  it.value())
+        return it.value();
+    MailTransport::Transport* transport = MailTransport::TransportManager::self()->transportById(id, true);
+    if (transport)
+        mTransports[id] = transport;
+    return transport;
+}
+
+/******************************************************************************
+* Return whether an email address is for a non-local destination.
+*/
+bool KAMail::isNonLocalAddress(const QString& email)
+{
+    QHash<QString, bool>::const_iterator it = mNonLocalAddresses.constFind(email);
+    if (it != mNonLocalAddresses.constEnd())
+        return it.value();
+    if (mHostName.isEmpty())
+        mHostName = QHostInfo::localHostName();
+    bool nonLocal = false;
+    KMime::Types::Address addr;
+    const QByteArray em8 = email.toLocal8Bit();
+    const char* em = em8.constData();
+    if (!em8.isEmpty()
+    &&  HeaderParsing::parseAddress(em, em + em8.length(), addr))
+    {
+        const QString domain = addr.mailboxList.at(0).addrSpec().domain;
+        nonLocal = !domain.isEmpty()  &&  domain != QLatin1String("localhost")  &&  domain != mHostName;
+    }
+    mNonLocalAddresses[email] = nonLocal;
+    return nonLocal;
+}
+
+/******************************************************************************
+* Return the path of a local mail program. The path is cached once found, until
+* the program fails to start or the mail environment changes.
+*/
+QString KAMail::mailProgram(const QString& name)
+{
+    QHash<QString, QString>::const_iterator it = mMailPrograms.constFind(name);
+    if (it != mMailPrograms.constEnd())
+        return it.value();
+    QStringList paths;
+    paths << QStringLiteral("/sbin") << QStringLiteral("/usr/sbin") << QStringLiteral("/usr/lib");
+    const QString path = QStandardPaths::findExecutable(name, paths);
+    if (path.isEmpty())
+        mMailPrograms.remove(name);
+    else
+        mMailPrograms[name] = path;
+    return path;
+}
+
+/******************************************************************************
+* Start delivering queued emails using local mail programs, provided that the
+* maximum number of concurrent deliveries for the mail program is not exceeded.
+* The message is written to the program's standard input without invoking a
+* shell, and its termination is notified asynchronously.
+*/
+void KAMail::startSendmailJobs()
+{
+    QHash<QString, int> active;
+    for (const SendmailProcess& p : qAsConst(mSendmailProcesses))
+        ++active[p.program];
+    for (int i = 0;  i < mSendmailJobs.count();  )
+    {
+        const SendmailJob& job = mSendmailJobs.at(i);
+        int& count = active[job.program];
+        if (count >= MAX_SENDMAIL_PROCESSES)
+        {
+            ++i;
+            continue;
+        }
+        ++count;
+        const SendmailJob j = mSendmailJobs.takeAt(i);
+        QProcess* proc = new QProcess(instance());
+        proc->setStandardOutputFile(QProcess::nullDevice());
+        SendmailProcess& p = mSendmailProcesses[proc];
+        p.program  = j.program;
+        p.sentCopy = j.sentCopy;
+        p.data     = j.data;
+        connect(proc, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                instance(), &KAMail::slotSendmailFinished);
+        connect(proc, &QProcess::errorOccurred, instance(), &KAMail::slotSendmailError);
+        qCDebug(KALARM_LOG) << "Starting" << j.program;
+        proc->start(j.program, j.args);
+        proc->write(j.message);
+        proc->closeWriteChannel();
+    }
+}
+
+/******************************************************************************
+* Called when a mail program has terminated.
+*/
+void KAMail::slotSendmailFinished(int exitCode, QProcess::ExitStatus status)
+{
+    QProcess* proc = qobject_cast<QProcess*>(sender());
+    QStringList errmsgs;
+    if (status != QProcess::NormalExit  ||  exitCode)
+    {
+        const QString err = QString::fromLocal8Bit(proc->readAllStandardError()).trimmed();
+        qCCritical(KALARM_LOG) << "Mail program failed, exit code" << exitCode << ":" << err;
+        errmsgs = errors(err, SEND_ERROR);
+    }
+    sendmailDone(proc, errmsgs);
+}
+
+/******************************************************************************
+* Called when an error occurs with a mail program.
+* Only failure to start is handled here; other errors are followed by the
+* finished() signal.
+*/
+void KAMail::slotSendmailError(QProcess::ProcessError error)
+{
+    if (error == QProcess::FailedToStart)
+    {
+        QProcess* proc = qobject_cast<QProcess*>(sender());
+        qCCritical(KALARM_LOG) << "Unable to start" << proc->program();
+        mMailPrograms.clear();   // look for the mail program again next time
+        sendmailDone(proc, errors());
+    }
+}
+
+/******************************************************************************
+* Notify the result of sending an email via a mail program, and start any
+* queued emails.
+*/
+void KAMail::sendmailDone(QProcess* proc, const QStringList& errmsgs)
+{
+    if (!mSendmailProcesses.contains(proc))
+        return;
+    const SendmailProcess p = mSendmailProcesses.take(proc);
+    JobData jobdata = p.data;
+    proc->deleteLater();
+    if (errmsgs.isEmpty())
+    {
+        if (p.sentCopy)
+            queueSentCopy(p.sentCopy);
+        if (jobdata.allowNotify)
+            notifyQueued(jobdata.event);
+    }
+    theApp()->emailSent(jobdata, errmsgs);
+    startSendmailJobs();
+}
+
+/******************************************************************************
+* Queue an email sent by a local mail program to be copied to the default
+* sent-mail folder. (Emails sent via a mail transport are moved to the sent-mail
+* folder by the mail dispatcher once they have actually been delivered.)
+* Copies are accumulated and written in batches in the background, so that
+* storing them never delays the sending of subsequent emails.
+*/
+void KAMail::queueSentCopy(const KMime::Message::Ptr& message)
+{
+    if (!message)
+        return;
+    mSentCopies += message;
+    if (!mSentCopyTimer)
+    {
+        mSentCopyTimer = new QTimer(instance());
+        mSentCopyTimer->setSingleShot(true);
+        connect(mSentCopyTimer, &QTimer::timeout, instance(), &KAMail::writeSentCopies);
+    }
+    if (mSentCopyBatch.isEmpty()  &&  !mSentCopyTimer->isActive())
+        mSentCopyTimer->start(SENT_COPY_DELAY);
+}
+
+/******************************************************************************
+* Start copying the next batch of sent emails to the sent-mail folder.
+* The sent-mail folder is first located (or created if necessary).
+*/
+void KAMail::writeSentCopies()
+{
+    if (!mSentCopyBatch.isEmpty()  ||  mSentCopies.isEmpty())
+        return;    // a batch is already being written, or nothing to write
+    mSentCopyBatch = mSentCopies.mid(0, SENT_COPY_BATCH);
+    mSentCopies.erase(mSentCopies.begin(), mSentCopies.begin() + mSentCopyBatch.count());
+    qCDebug(KALARM_LOG) << "Copying" << mSentCopyBatch.count() << "emails to sent-mail folder";
+    Akonadi::SpecialMailCollectionsRequestJob* job = new Akonadi::SpecialMailCollectionsRequestJob(instance());
+    job->requestDefaultCollection(Akonadi::SpecialMailCollections::SentMail);
+    connect(job, &KJob::result, instance(), &KAMail::slotSentCollectionFetched);
+    job->start();
+}
+
+/******************************************************************************
+* Called when the sent-mail folder has been located.
+* Add the current batch of sent emails to it in a single transaction.
+*/
+void KAMail::slotSentCollectionFetched(KJob* job)
+{
+    const Akonadi::Collection collection = job->error() ? Akonadi::Collection()
+                 : Akonadi::SpecialMailCollections::self()->defaultCollection(Akonadi::SpecialMailCollections::SentMail);
+    if (!collection.isValid())
+    {
+        qCCritical(KALARM_LOG) << "Sent-mail folder not found:" << job->errorString();
+        slotSentCopiesWritten(nullptr);
+        return;
+    }
+    Akonadi::TransactionSequence* transaction = new Akonadi::TransactionSequence(instance());
+    for (const KMime::Message::Ptr& message : qAsConst(mSentCopyBatch))
+    {
+        Akonadi::Item item;
+        item.setMimeType(KMime::Message::mimeType());
+        item.setPayload<KMime::Message::Ptr>(message);
+        item.setFlag(Akonadi::MessageFlags::Seen);
+        new Akonadi::ItemCreateJob(item, collection, transaction);
+    }
+    connect(transaction, &KJob::result, instance(), &KAMail::slotSentCopiesWritten);
+}
+
+/******************************************************************************
+* Called when a batch of sent emails has been copied to the sent-mail folder,
+* or copying has failed. Failed copies are discarded, and any further queued
+* emails are then written.
+*/
+void KAMail::slotSentCopiesWritten(KJob* job)
+{
+    if (job  &&  job->error())
+        qCCritical(KALARM_LOG) << "Error copying" << mSentCopyBatch.count() << "emails to sent-mail folder:" << job->errorString();
+    mSentCopyBatch.clear();
+    if (!mSentCopies.isEmpty())
+        mSentCopyTimer->start(SENT_COPY_DELAY);
+}
+
 /******************************************************************************
 * Create the headers part of the email.
 */
@@ -478,23 +768,15 @@ QString KAMail::appendBodyAttachments(KMime::Message& message, JobData& data)
 */
 void KAMail::notifyQueued(const KAEvent& event)
 {
-    KMime::Types::Address addr;
-    const QString localhost = QStringLiteral("localhost");
-    const QString hostname  = QHostInfo::localHostName();
-    KCalCore::Person::List addresses = event.emailAddressees();
+    if (!KAMessageBox::shouldBeShownContinue(Preferences::EMAIL_QUEUED_NOTIFY))
+        return;   // the notification has been disabled
+    const KCalCore::Person::List addresses = event.emailAddressees();
     for (int i = 0, end = addresses.count();  i < end;  ++i)
     {
-        QByteArray email = addresses[i]->email().toLocal8Bit();
-        const char* em = email;
-        if (!email.isEmpty()
-        &&  HeaderParsing::parseAddress(em, em + email.length(), addr))
+        if (isNonLocalAddress(addresses[i]->email()))
         {
-            QString domain = addr.mailboxList.at(0).addrSpec().domain;
-            if (!domain.isEmpty()  &&  domain != localhost  &&  domain != hostname)
-            {
-                KAMessageBox::information(MainWindow::mainMainWindow(), i18nc("@info", "An email has been queued to be sent"), QString(), Preferences::EMAIL_QUEUED_NOTIFY);
-                return;
-            }
+            KAMessageBox::information(MainWindow::mainMainWindow(), i18nc("@info", "An email has been queued to be sent"), QString(), Preferences::EMAIL_QUEUED_NOTIFY);
+            return;
         }
     }
 }
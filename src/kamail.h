@@ -25,14 +25,19 @@
 
 #include <KCalCore/Person>
 
+#include <QHash>
 #include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 #include <QQueue>
 
 class QUrl;
+class QTimer;
 class KJob;
-namespace MailTransport  { class MessageQueueJob; }
+namespace MailTransport  { class MessageQueueJob; class Transport; }
 namespace KMime {
     namespace Types { struct Address; }
     class Message;
@@ -72,18 +77,64 @@ class KAMail : public QObject
 
     private Q_SLOTS:
         void               slotEmailSent(KJob*);
+        void               slotSendmailFinished(int exitCode, QProcess::ExitStatus);
+        void               slotSendmailError(QProcess::ProcessError);
+        void               slotEnvironmentChanged();
+        void               writeSentCopies();
+        void               slotSentCollectionFetched(KJob*);
+        void               slotSentCopiesWritten(KJob*);
 
     private:
+        // Data for an email to be sent by a local mail program
+        struct SendmailJob
+        {
+            QString     program;    // path of mail program
+            QStringList args;       // arguments for mail program
+            QByteArray  message;    // encoded message to write to its stdin
+            QSharedPointer<KMime::Message> sentCopy;  // message to copy to the sent-mail folder, or null
+            JobData     data;
+        };
+        struct SendmailProcess
+        {
+            QString     program;
+            QSharedPointer<KMime::Message> sentCopy;
+            JobData     data;
+        };
+
         KAMail() {}
         static KAMail*     instance();
+        static void        initEnvironment();
+        static void        clearEnvironment();
+        static QString     fromAddress();
+        static QString     bccAddress();
+        static MailTransport::Transport* transport(int id);
+        static bool        isNonLocalAddress(const QString& email);
+        static QString     mailProgram(const QString& name);
+        static void        startSendmailJobs();
+        void               sendmailDone(QProcess*, const QStringList& errmsgs);
         static QString     appendBodyAttachments(KMime::Message& message, JobData&);
         static void        notifyQueued(const KAEvent&);
+        static void        queueSentCopy(const QSharedPointer<KMime::Message>&);
         enum ErrType { SEND_FAIL, SEND_ERROR };
         static QStringList errors(const QString& error = QString(), ErrType = SEND_FAIL);
 
         static KAMail*     mInstance;
         static QQueue<MailTransport::MessageQueueJob*> mJobs;
         static QQueue<JobData>                         mJobData;
+        // Mail environment cache, cleared when preferences, identities or transports change
+        static bool                                    mEnvironmentInitialised;
+        static bool                                    mAddressesCached;   // mFromAddress and mBccAddress are valid
+        static QString                                 mFromAddress;       // default 'From' address
+        static QString                                 mBccAddress;        // default 'Bcc' address
+        static QString                                 mHostName;          // local host name
+        static QHash<int, QPointer<MailTransport::Transport> > mTransports;  // mail transports, by ID
+        static QHash<QString, bool>                    mNonLocalAddresses; // whether each address is non-local
+        static QHash<QString, QString>                 mMailPrograms;      // cached mail program paths
+        static QQueue<SendmailJob>                     mSendmailJobs;      // emails waiting for a mail program
+        static QHash<QProcess*, SendmailProcess>       mSendmailProcesses; // active mail program processes
+        static QList<QSharedPointer<KMime::Message> >  mSentCopies;        // sent emails waiting to be copied to sent-mail folder
+        static QList<QSharedPointer<KMime::Message> >  mSentCopyBatch;     // sent emails currently being copied
+        static QTimer*                                 mSentCopyTimer;     // delays copying sent emails, to batch them
 };
 
 #endif // KAMAIL_H
@@ -177,6 +177,16 @@ class KAMessageBox
                                 KMessageBox::Options options = KMessageBox::Options(KMessageBox::Notify|KMessageBox::Dangerous|KMessageBox::WindowModal))
         { return KMessageBox::warningYesNo(parent, text, caption, buttonYes, buttonNo, dontAskAgainName, options); }
 
+        /** Same as KMessageBox::warningYesNoList() except that it defaults to window-modal,
+         *  not application-modal. */
+        static int warningYesNoList(QWidget* parent, const QString& text, const QStringList& strlist,
+                                    const QString& caption = QString(),
+                                    const KGuiItem& buttonYes = KStandardGuiItem::yes(),
+                                    const KGuiItem& buttonNo = KStandardGuiItem::no(),
+                                    const QString& dontAskAgainName = QString(),
+                                    KMessageBox::Options options = KMessageBox::Options(KMessageBox::Notify|KMessageBox::Dangerous|KMessageBox::WindowModal))
+        { return KMessageBox::warningYesNoList(parent, text, strlist, caption, buttonYes, buttonNo, dontAskAgainName, options); }
+
         /** Shortcut to represent Options(Notify | WindowModal). */
         static const KMessageBox::Options NoAppModal;
 
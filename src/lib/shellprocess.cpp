@@ -25,6 +25,7 @@
 #include "kalarm_debug.h"
 #include <kauthorized.h>
 #include <qglobal.h>
+#include <QTimer>
 
 #include <stdlib.h>
 
@@ -39,12 +40,16 @@ ShellProcess::ShellProcess(const QString& command)
     : mCommand(command),
       mStdinBytes(0),
       mStatus(INACTIVE),
-      mStdinExit(false)
+      mStdinExit(false),
+      mStarting(false)
 {
 }
 
 /******************************************************************************
 * Execute a command.
+* This returns without waiting for the process to start, so that starting
+* many commands doesn't block the caller. Failure to start is notified by
+* slotError().
 */
 bool ShellProcess::start(OpenMode openMode)
 {
@@ -57,16 +62,41 @@ bool ShellProcess::start(OpenMode openMode)
     connect(this, SIGNAL(finished(int,QProcess::ExitStatus)), SLOT(slotExited(int,QProcess::ExitStatus)));
     connect(this, &QProcess::readyReadStandardOutput, this, &ShellProcess::stdoutReady);
     connect(this, &QProcess::readyReadStandardError, this, &ShellProcess::stderrReady);
+    connect(this, &QProcess::errorOccurred, this, &ShellProcess::slotError);
     QStringList args;
     args << QStringLiteral("-c") << mCommand;
-    QProcess::start(QLatin1String(shellName()), args, openMode);
-    if (!waitForStarted())
-    {
-        mStatus = START_FAIL;
-        return false;
-    }
     mStatus = RUNNING;
-    return true;
+    mStarting = true;
+    QProcess::start(QLatin1String(shellName()), args, openMode);
+    mStarting = false;
+    return mStatus != START_FAIL;   // failure may be reported before start() returns
+}
+
+/******************************************************************************
+* Called when an error occurs with the process.
+* If the process failed to start, emit a shellExited() signal (unless start()
+* is still executing, in which case it reports the failure itself). Other
+* errors are followed by QProcess::finished(), which is handled by slotExited().
+* The signal is emitted asynchronously, since the receiver may delete this
+* process, and QProcess still uses it after errorOccurred() returns.
+*/
+void ShellProcess::slotError(QProcess::ProcessError err)
+{
+    if (err != QProcess::FailedToStart  ||  mStatus != RUNNING)
+        return;
+    qCWarning(KALARM_LOG) << mCommand << ":" << mShellName << ": failed to start";
+    mStdinQueue.clear();
+    mStatus = START_FAIL;
+    if (!mStarting)
+        QTimer::singleShot(0, this, &ShellProcess::slotStartFailed);
+}
+
+/******************************************************************************
+* Called after the error handling for a failure to start has completed.
+*/
+void ShellProcess::slotStartFailed()
+{
+    Q_EMIT shellExited(this);
 }
 
 /******************************************************************************
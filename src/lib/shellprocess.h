@@ -55,7 +55,7 @@ class ShellProcess : public KProcess
     public:
         /** Current status of the shell process.
          *  @li INACTIVE - start() has not yet been called to run the command.
-         *  @li RUNNING - the command is currently running.
+         *  @li RUNNING - the command is currently starting or running.
          *  @li SUCCESS - the command appears to have exited successfully.
          *  @li UNAUTHORISED - shell commands are not authorised for this user.
          *  @li DIED - the command didn't exit cleanly, i.e. was killed or died.
@@ -64,7 +64,7 @@ class ShellProcess : public KProcess
          */
         enum Status {
             INACTIVE,     // start() has not yet been called to run the command
-            RUNNING,      // command is currently running
+            RUNNING,      // command is currently starting or running
             SUCCESS,      // command appears to have exited successfully
             UNAUTHORISED, // shell commands are not authorised for this user
             DIED,         // command didn't exit cleanly, i.e. was killed or died
@@ -75,8 +75,12 @@ class ShellProcess : public KProcess
          *  @param command The command line to be run when start() is called.
          */
         explicit ShellProcess(const QString& command);
-        /** Executes the configured command.
+        /** Executes the configured command. This does not wait for the
+         *  command to start: if it subsequently fails to start, status() is set
+         *  to START_FAIL and shellExited() is emitted.
          *  @param openMode WriteOnly for stdin only, ReadOnly for stdout/stderr only, else ReadWrite.
+         *  @return false if the command could not be started, in which case
+         *          shellExited() is not emitted.
          */
         bool            start(OpenMode = ReadWrite);
         /** Returns the current status of the shell process. */
@@ -112,8 +116,9 @@ class ShellProcess : public KProcess
         static const QByteArray& shellPath();
 
     Q_SIGNALS:
-        /** Signal emitted when the shell process execution completes. It is not emitted
-         *  if start() did not attempt to start the command execution, e.g. in kiosk mode.
+        /** Signal emitted when the shell process execution completes, or when the
+         *  command fails to start. It is not emitted if start() returned false,
+         *  e.g. in kiosk mode.
          */
         void  shellExited(ShellProcess*);
         /** Signal emitted when input is available from the process's stdout. */
@@ -126,6 +131,8 @@ class ShellProcess : public KProcess
         void  stdoutReady()         { Q_EMIT receivedStdout(this); }
         void  stderrReady()         { Q_EMIT receivedStderr(this); }
         void  slotExited(int exitCode, QProcess::ExitStatus);
+        void  slotError(QProcess::ProcessError);
+        void  slotStartFailed();
 
     private:
         // Prohibit the following inherited methods
@@ -142,6 +149,7 @@ class ShellProcess : public KProcess
         int                mExitCode;     // shell exit value (if mStatus == SUCCESS or NOT_FOUND)
         Status             mStatus;       // current execution status
         bool               mStdinExit;    // exit once STDIN queue has been written
+        bool               mStarting;     // start() is executing
 };
 
 #endif // SHELLPROCESS_H
@@ -23,7 +23,10 @@
 
 #include <QTimer>
 #include <QDateTime>
+#include <QEvent>
+#include <QMetaMethod>
 #include <QTime>
+#include <QWidget>
 #include "kalarm_debug.h"
 
 /*=============================================================================
@@ -55,7 +58,7 @@ void SynchTimer::connecT(QObject* receiver, const char* member)
     mConnections.append(connection);
     if (!mTimer->isActive())
     {
-        connect(mTimer, &QTimer::timeout, this, &SynchTimer::slotTimer);
+        connect(mTimer, &QTimer::timeout, this, &SynchTimer::slotTimer, Qt::UniqueConnection);
         start();
     }
 }
@@ -93,6 +96,21 @@ void SynchTimer::disconnecT(QObject* receiver, const char* member)
 }
 
 
+/******************************************************************************
+* Return the connections to the timer for a given receiver.
+*/
+QList<SynchTimer::Connection> SynchTimer::connections(const QObject* receiver) const
+{
+    QList<Connection> conns;
+    for (int i = 0, count = mConnections.count();  i < count;  ++i)
+    {
+        if (mConnections[i].receiver == receiver)
+            conns += mConnections[i];
+    }
+    return conns;
+}
+
+
 /*=============================================================================
 =  Class: MinuteTimer
 =  Application-wide timer synchronized to the minute boundary.
@@ -107,6 +125,150 @@ MinuteTimer* MinuteTimer::instance()
     return mInstance;
 }
 
+MinuteTimer::MinuteTimer()
+    : SynchTimer()
+{
+    // Allow the system to coalesce the timer's wakeups with other timers.
+    mTimer->setTimerType(Qt::VeryCoarseTimer);
+}
+
+/******************************************************************************
+* Connect to the timer signal.
+* If the receiver is a widget, it is suspended while it is hidden.
+*/
+void MinuteTimer::connect(QObject* receiver, const char* member)
+{
+    MinuteTimer* timer = instance();
+    const bool newReceiver = timer->connections(receiver).isEmpty();
+    timer->connecT(receiver, member);
+    if (newReceiver)
+    {
+        QObject::connect(receiver, &QObject::destroyed, timer, &MinuteTimer::slotReceiverDestroyed);
+        if (receiver->isWidgetType())
+            receiver->installEventFilter(timer);
+    }
+    if (timer->mSuspended.contains(receiver))
+        timer->mTimer->disconnect(receiver, member);   // the receiver is already suspended
+    else
+        timer->updateSuspension(receiver);
+}
+
+/******************************************************************************
+* Disconnect from the timer signal.
+*/
+void MinuteTimer::disconnect(QObject* receiver, const char* member)
+{
+    if (!mInstance)
+        return;
+    mInstance->disconnecT(receiver, member);
+    if (mInstance->connections(receiver).isEmpty())
+    {
+        QObject::disconnect(receiver, &QObject::destroyed, mInstance, &MinuteTimer::slotReceiverDestroyed);
+        receiver->removeEventFilter(mInstance);
+        mInstance->mSuspended.remove(receiver);
+        mInstance->mExplicitSuspended.remove(receiver);
+    }
+    mInstance->checkTimerNeeded();
+}
+
+/******************************************************************************
+* Suspend or resume notifications to a receiver.
+*/
+void MinuteTimer::setSuspended(QObject* receiver, bool suspended)
+{
+    MinuteTimer* timer = instance();
+    if (suspended)
+        timer->mExplicitSuspended.insert(receiver);
+    else
+        timer->mExplicitSuspended.remove(receiver);
+    timer->updateSuspension(receiver);
+}
+
+/******************************************************************************
+* Called when a receiver is deleted without being disconnected.
+*/
+void MinuteTimer::slotReceiverDestroyed(QObject* receiver)
+{
+    disconnecT(receiver);
+    mSuspended.remove(receiver);
+    mExplicitSuspended.remove(receiver);
+    checkTimerNeeded();
+}
+
+/******************************************************************************
+* Called when a widget receiver is shown or hidden.
+*/
+bool MinuteTimer::eventFilter(QObject* receiver, QEvent* e)
+{
+    if (e->type() == QEvent::Show  ||  e->type() == QEvent::Hide)
+        updateSuspension(receiver);
+    return false;
+}
+
+/******************************************************************************
+* Suspend or resume a receiver's notifications, according to whether it has
+* been explicitly suspended, or if it is a widget, whether it is visible.
+* On resumption, its slots are activated if it missed a minute boundary.
+*/
+void MinuteTimer::updateSuspension(QObject* receiver)
+{
+    const QList<Connection> conns = connections(receiver);
+    if (conns.isEmpty())
+        return;
+    const bool suspend = mExplicitSuspended.contains(receiver)
+                     ||  (receiver->isWidgetType() && !static_cast<QWidget*>(receiver)->isVisible());
+    QHash<QObject*, QDateTime>::iterator it = mSuspended.find(receiver);
+    if (suspend == (it != mSuspended.end()))
+        return;    // no change
+    if (suspend)
+    {
+        qCDebug(KALARM_LOG) << "Suspend" << receiver;
+        for (const Connection& conn : conns)
+            mTimer->disconnect(receiver, conn.slot.constData());
+        mSuspended.insert(receiver, QDateTime::currentDateTime());
+        checkTimerNeeded();
+    }
+    else
+    {
+        qCDebug(KALARM_LOG) << "Resume" << receiver;
+        const QDateTime suspendTime = it.value();
+        mSuspended.erase(it);
+        const QDateTime now = QDateTime::currentDateTime();
+        const bool missed = (now.date() != suspendTime.date()
+                         ||  now.time().hour() != suspendTime.time().hour()
+                         ||  now.time().minute() != suspendTime.time().minute());
+        for (const Connection& conn : conns)
+        {
+            QObject::connect(mTimer, SIGNAL(timeout()), receiver, conn.slot.constData());
+            if (missed)
+            {
+                // Catch up with the update missed while suspended
+                const QMetaObject* meta = receiver->metaObject();
+                const int index = meta->indexOfMethod(QMetaObject::normalizedSignature(conn.slot.constData() + 1));
+                if (index >= 0)
+                    meta->method(index).invoke(receiver, Qt::QueuedConnection);
+            }
+        }
+        if (!mTimer->isActive())
+            start();
+    }
+}
+
+/******************************************************************************
+* Stop the timer if all receivers are suspended, to avoid needless wakeups.
+*/
+void MinuteTimer::checkTimerNeeded()
+{
+    if (mTimer->isActive()  &&  hasConnections())
+    {
+        for (const Connection& conn : connections())
+            if (!mSuspended.contains(conn.receiver))
+                return;
+        qCDebug(KALARM_LOG) << "All receivers suspended";
+        mTimer->stop();
+    }
+}
+
 /******************************************************************************
 * Called when the timer triggers, or to start the timer.
 * Timers can under some circumstances wander off from the correct trigger time,
@@ -116,8 +278,9 @@ MinuteTimer* MinuteTimer::instance()
 void MinuteTimer::slotTimer()
 {
     qCDebug(KALARM_LOG);
-    int interval = 62 - QTime::currentTime().second();
-    mTimer->start(interval * 1000);     // execute a single shot
+    const QTime now = QTime::currentTime();
+    int interval = 62000 - now.second() * 1000 - now.msec();
+    mTimer->start(interval);     // execute a single shot
 }
 
 
@@ -25,7 +25,10 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QSet>
 #include <QByteArray>
+#include <QDateTime>
 #include <QTime>
 #include <QDate>
 class QTimer;
@@ -55,6 +58,8 @@ class SynchTimer : public QObject
         void                connecT(QObject* receiver, const char* member);
         void                disconnecT(QObject* receiver, const char* member = nullptr);
         bool                hasConnections() const   { return !mConnections.isEmpty(); }
+        const QList<Connection>& connections() const   { return mConnections; }
+        QList<Connection>   connections(const QObject* receiver) const;
 
         QTimer*             mTimer;
 
@@ -71,6 +76,11 @@ class SynchTimer : public QObject
 
 
 /** MinuteTimer is an application-wide timer synchronized to the minute boundary.
+ *
+ *  Receivers which are widgets are not notified while they are hidden, and
+ *  other receivers may be suspended explicitly. When a receiver is resumed or
+ *  shown again, it is notified immediately if a minute boundary has passed
+ *  while it was suspended. If all receivers are suspended, the timer stops.
  *
  *  @author David Jarvie <djarvie@kde.org>
  */
@@ -83,26 +93,40 @@ class MinuteTimer : public SynchTimer
          *  @param receiver Receiving object.
          *  @param member Slot to activate.
          */
-        static void connect(QObject* receiver, const char* member)
-                           { instance()->connecT(receiver, member); }
+        static void connect(QObject* receiver, const char* member);
         /** Disconnect from the timer signal.
          *  @param receiver Receiving object.
          *  @param member Slot to disconnect. If null, all slots belonging to
          *                @p receiver will be disconnected.
          */
-        static void disconnect(QObject* receiver, const char* member = nullptr)
-                           { if (mInstance) mInstance->disconnecT(receiver, member); }
+        static void disconnect(QObject* receiver, const char* member = nullptr);
+        /** Suspend or resume notifications to a receiver, e.g. while its output
+         *  is not visible. On resumption, the receiver's slots are activated if a
+         *  minute boundary has passed while it was suspended.
+         *  @param receiver  Receiving object.
+         *  @param suspended True to suspend, false to resume.
+         */
+        static void setSuspended(QObject* receiver, bool suspended);
 
     protected:
-        MinuteTimer() : SynchTimer() { }
+        MinuteTimer();
         static MinuteTimer* instance();
         void        start() override    { slotTimer(); }
+        bool        eventFilter(QObject*, QEvent*) override;
 
     protected Q_SLOTS:
         void        slotTimer() override;
 
+    private Q_SLOTS:
+        void        slotReceiverDestroyed(QObject*);
+
     private:
-        static MinuteTimer* mInstance;     // the one and only instance
+        void        updateSuspension(QObject* receiver);
+        void        checkTimerNeeded();
+
+        static MinuteTimer*       mInstance;     // the one and only instance
+        QHash<QObject*, QDateTime> mSuspended;   // suspended receivers, with the time they were suspended
+        QSet<QObject*>            mExplicitSuspended;  // receivers suspended by setSuspended()
 };
 
 
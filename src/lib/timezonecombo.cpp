@@ -22,33 +22,61 @@
 #include <ksystemtimezone.h>
 #include <KLocalizedString>
 
+#include <QCoreApplication>
+#include <QStringListModel>
+
+QStringListModel*   TimeZoneCombo::mModel = nullptr;
+QStringList         TimeZoneCombo::mZoneNames;
+QHash<QString, int> TimeZoneCombo::mZoneRows;
+
 
 TimeZoneCombo::TimeZoneCombo(QWidget* parent)
     : ComboBox(parent)
 {
+    initModel();
+    setModel(mModel);
+}
+
+/******************************************************************************
+* Build the shared list of time zones, if it has not already been built.
+*/
+void TimeZoneCombo::initModel()
+{
+    if (mModel)
+        return;
+    QStringList displayNames;
     QString utc = KTimeZone::utc().name();
-    addItem(utc);   // put UTC at start of list
+    displayNames << utc;   // put UTC at start of list
     mZoneNames << utc;
     const KTimeZones::ZoneMap zones = KSystemTimeZones::zones();
+    displayNames.reserve(zones.count() + 1);
+    mZoneNames.reserve(zones.count() + 1);
     KTimeZones::ZoneMap::ConstIterator end = zones.constEnd();
     for (KTimeZones::ZoneMap::ConstIterator it = zones.constBegin();  it != end;  ++it)
         if (it.key() != utc)
         {
             mZoneNames << it.key();
-            addItem(i18n(it.key().toUtf8()).replace(QLatin1Char('_'), QLatin1Char(' ')));
+            displayNames << i18n(it.key().toUtf8()).replace(QLatin1Char('_'), QLatin1Char(' '));
         }
+    mZoneRows.reserve(mZoneNames.count());
+    for (int i = 0, count = mZoneNames.count();  i < count;  ++i)
+        mZoneRows.insert(mZoneNames[i], i);
+    mModel = new QStringListModel(displayNames, QCoreApplication::instance());
 }
 
 KTimeZone TimeZoneCombo::timeZone() const
 {
-    return KSystemTimeZones::zone(mZoneNames[currentIndex()]);
+    int index = currentIndex();
+    if (index < 0  ||  index >= mZoneNames.count())
+        return KTimeZone();
+    return KSystemTimeZones::zone(mZoneNames[index]);
 }
 
 void TimeZoneCombo::setTimeZone(const KTimeZone& tz)
 {
     if (!tz.isValid())
         return;
-    int index = mZoneNames.indexOf(tz.name());
+    int index = mZoneRows.value(tz.name(), -1);
     if (index >= 0)
         setCurrentIndex(index);
 }
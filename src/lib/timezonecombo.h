@@ -22,9 +22,11 @@
 #define TIMEZONECOMBO_H
 
 #include <combobox.h>
+#include <QHash>
 #include <QStringList>
 
 class KTimeZone;
+class QStringListModel;
 
 /**
  *  @short A combo box for selecting a time zone, with a read-only option.
@@ -32,6 +34,8 @@ class KTimeZone;
  *  The widget may be set as read-only. This has the same effect as disabling it, except
  *  that its appearance is unchanged.
  *
+ *  The list of time zones is built only once, and is shared between all instances.
+ *
  *  @author David Jarvie <djarvie@kde.org>
  */
 class TimeZoneCombo : public ComboBox
@@ -48,7 +52,11 @@ class TimeZoneCombo : public ComboBox
         void setTimeZone(const KTimeZone& tz);
 
     private:
-        QStringList mZoneNames;
+        static void initModel();
+
+        static QStringListModel* mModel;       // shared model containing translated zone names
+        static QStringList       mZoneNames;   // zone names, in the same order as mModel
+        static QHash<QString, int> mZoneRows;  // row in mModel for each zone name
 };
 
 #endif // TIMEZONECOMBO_H
@@ -49,6 +49,8 @@
 #include <Libkdepim/MaillistDrag>
 #include <kmime/kmime_content.h>
 #include <AkonadiWidgets/controlgui.h>
+#include <KCalCore/FileStorage>
+#include <KCalCore/ICalFormat>
 #include <KCalCore/MemoryCalendar>
 #include <KCalUtils/kcalutils/icaldrag.h>
 using namespace KCalCore;
@@ -77,7 +79,11 @@ using namespace KCalUtils;
 #include <QCloseEvent>
 #include <QDesktopWidget>
 #include <QMenu>
+#include <QMimeData>
 #include <QMimeDatabase>
+#include <QPointer>
+#include <QProgressDialog>
+#include <QThread>
 #include <qinputdialog.h>
 #include <QUrl>
 #include <QSystemTrayIcon>
@@ -105,6 +111,37 @@ QList<QKeySequence> redoShortcut;
 }
 
 
+/*=============================================================================
+= Class: CalendarDropParser
+= Parses dropped iCalendar data in a separate thread, so that dropping a large
+= calendar does not block the GUI.
+=============================================================================*/
+class CalendarDropParser : public QThread
+{
+    public:
+        explicit CalendarDropParser(const QByteArray& data)
+            : QThread(),
+              mData(data),
+              mCalendar(new MemoryCalendar(Preferences::qTimeZone(true))),
+              mOk(false)
+        {}
+        MemoryCalendar::Ptr calendar() const  { return mCalendar; }
+        bool                ok() const        { return mOk; }
+
+    protected:
+        void run() override
+        {
+            ICalFormat format;
+            mOk = format.fromRawString(mCalendar, mData);
+        }
+
+    private:
+        QByteArray          mData;
+        MemoryCalendar::Ptr mCalendar;
+        bool                mOk;
+};
+
+
 /*=============================================================================
 =  Class: MainWindow
 =============================================================================*/
@@ -196,6 +233,7 @@ MainWindow::MainWindow(bool restored)
             theApp()->trayWindow()->setAssocMainWindow(this);    // associate this window with the system tray icon
     }
     slotCalendarStatusChanged();   // initialise action states now that window is registered
+    checkTimeToDisplayed();
 }
 
 MainWindow::~MainWindow()
@@ -203,6 +241,7 @@ MainWindow::~MainWindow()
     qCDebug(KALARM_LOG);
     bool trayParent = isTrayParent();   // must call before removing from window list
     mWindowList.removeAt(mWindowList.indexOf(this));
+    checkTimeToDisplayed();
 
     // Prevent view updates during window destruction
     delete mResourceSelector;
@@ -391,6 +430,8 @@ void MainWindow::showEvent(QShowEvent* se)
     }
     MainWindowBase::showEvent(se);
     mShown = true;
+    checkTimeToDisplayed();
+    EditAlarmDlg::prewarm();    // prepare New Alarm dialogs for instant display
 }
 
 /******************************************************************************
@@ -415,6 +456,25 @@ void MainWindow::show()
 void MainWindow::hideEvent(QHideEvent* he)
 {
     MainWindowBase::hideEvent(he);
+    checkTimeToDisplayed();
+}
+
+/******************************************************************************
+* Check whether any main window is displaying the time-to-alarm column, and
+* enable or disable the minute updates of its values accordingly.
+*/
+void MainWindow::checkTimeToDisplayed()
+{
+    bool displayed = false;
+    for (const MainWindow* win : mWindowList)
+    {
+        if (win->mShowTimeTo  &&  win->isVisible())
+        {
+            displayed = true;
+            break;
+        }
+    }
+    AkonadiModel::instance()->enableTimeToUpdates(displayed);
 }
 
 /******************************************************************************
@@ -689,6 +749,26 @@ KAEvent MainWindow::selectedEvent() const
     return mListView->selectedEvent();
 }
 
+/******************************************************************************
+* Return the selected alarms in the displayed list, as held in the resources
+* calendar. No copies of the events are made. Any alarm which is no longer in
+* the calendar is omitted.
+*/
+KAEvent::List MainWindow::selectedCalendarEvents() const
+{
+    const QVector<EventId> ids = mListView->selectedEventIds();
+    KAEvent::List events;
+    events.reserve(ids.count());
+    AlarmCalendar* resources = AlarmCalendar::resources();
+    for (const EventId& id : ids)
+    {
+        KAEvent* event = resources->event(id);
+        if (event)
+            events += event;
+    }
+    return events;
+}
+
 /******************************************************************************
 * Deselect all alarms in the displayed list.
 */
@@ -753,10 +833,9 @@ void MainWindow::slotModify()
 */
 void MainWindow::slotDelete(bool force)
 {
-    QVector<KAEvent> events = mListView->selectedEvents();
     if (!force  &&  Preferences::confirmAlarmDeletion())
     {
-        int n = events.count();
+        int n = mListView->selectedCount();
         if (KAMessageBox::warningContinueCancel(this, i18ncp("@info", "Do you really want to delete the selected alarm?",
                                                              "Do you really want to delete the %1 selected alarms?", n),
                                                 i18ncp("@title:window", "Delete Alarm", "Delete Alarms", n),
@@ -767,16 +846,19 @@ void MainWindow::slotDelete(bool force)
             return;
     }
 
+    // Only fetch the events now, since alarms may have been deleted while
+    // the confirmation prompt was displayed.
     // Remove any events which have just triggered, from the list to delete.
+    KAEvent::List events = selectedCalendarEvents();
     Undo::EventList undos;
     AlarmCalendar* resources = AlarmCalendar::resources();
     for (int i = 0;  i < events.count();  )
     {
-        Akonadi::Collection c = resources->collectionForEvent(events[i].itemId());
+        Akonadi::Collection c = resources->collectionForEvent(events[i]->itemId());
         if (!c.isValid())
             events.remove(i);
         else
-            undos.append(events[i++], c);
+            undos.append(*events[i++], c);
     }
 
     if (events.isEmpty())
@@ -795,7 +877,12 @@ void MainWindow::slotDelete(bool force)
 */
 void MainWindow::slotReactivate()
 {
-    QVector<KAEvent> events = mListView->selectedEvents();
+    // Copy the events, since reactivation replaces them with new active events.
+    const KAEvent::List selected = selectedCalendarEvents();
+    QVector<KAEvent> events;
+    events.reserve(selected.count());
+    for (const KAEvent* event : selected)
+        events += *event;
     mListView->clearSelection();
 
     // Add the alarms to the displayed lists and to the calendar file
@@ -822,11 +909,7 @@ void MainWindow::slotReactivate()
 void MainWindow::slotEnable()
 {
     bool enable = mActionEnableEnable;    // save since changed in response to KAlarm::enableEvent()
-    QVector<KAEvent> events = mListView->selectedEvents();
-    QVector<KAEvent> eventCopies;
-    for (int i = 0, end = events.count();  i < end;  ++i)
-        eventCopies += events[i];
-    KAlarm::enableEvents(eventCopies, enable, this);
+    KAlarm::enableEvents(selectedCalendarEvents(), enable, this);
     slotSelection();   // update Enable/Disable action text
 }
 
@@ -845,6 +928,7 @@ void MainWindow::slotShowTime()
         KConfigGroup config(KSharedConfig::openConfig(), VIEW_GROUP);
         config.writeEntry(SHOW_TIME_KEY, mShowTime);
         config.writeEntry(SHOW_TIME_TO_KEY, mShowTimeTo);
+        checkTimeToDisplayed();
     }
 }
 
@@ -863,6 +947,7 @@ void MainWindow::slotShowTimeTo()
         KConfigGroup config(KSharedConfig::openConfig(), VIEW_GROUP);
         config.writeEntry(SHOW_TIME_KEY, mShowTime);
         config.writeEntry(SHOW_TIME_TO_KEY, mShowTimeTo);
+        checkTimeToDisplayed();
     }
 }
 
@@ -913,12 +998,9 @@ void MainWindow::slotImportAlarms()
 */
 void MainWindow::slotExportAlarms()
 {
-    QVector<KAEvent> events = mListView->selectedEvents();
+    const KAEvent::List events = selectedCalendarEvents();
     if (!events.isEmpty())
-    {
-        KAEvent::List evts = KAEvent::ptrList(events);
-        AlarmCalendar::exportAlarms(evts, this);
-    }
+        AlarmCalendar::exportAlarms(events, this);
 }
 
 /******************************************************************************
@@ -1260,20 +1342,143 @@ static QString getMailHeader(const char* header, KMime::Content& content)
     return hd ? hd->asUnicodeString() : QString();
 }
 
+/******************************************************************************
+* Parse dropped iCalendar data in a separate thread, showing a non-modal
+* progress indicator if it takes any time. When parsing is complete, the
+* alarm(s) are created from its contents.
+* If the data can't be parsed, the dropped URLs or text are used instead, as
+* for a drop which doesn't contain a calendar.
+* The parser thread has no parent, so that closing a window can't destroy it
+* while it is running; it deletes itself once it has finished. Cancelling the
+* progress indicator discards the result, since parsing can't be interrupted.
+*/
+void MainWindow::parseDroppedCalendar(MainWindow* win, const QByteArray& icalData, const QList<QUrl>& urls, const QString& text)
+{
+    QPointer<MainWindow> window(win);
+    QPointer<QProgressDialog> progress = new QProgressDialog(i18nc("@info", "Reading dropped calendar..."),
+                                                             i18nc("@action:button", "Cancel"), 0, 0, mainMainWindow());
+    progress->setWindowModality(Qt::NonModal);
+    progress->setMinimumDuration(500);
+    CalendarDropParser* parser = new CalendarDropParser(icalData);
+    connect(parser, &QThread::finished, parser, [window, parser, progress, urls, text]()
+    {
+        parser->wait();    // ensure that the thread has fully terminated
+        const bool cancelled = !progress  ||  progress->wasCanceled();
+        delete progress.data();
+        if (cancelled)
+            return;
+        if (parser->ok())
+            executeCalendarDrop(window, parser->calendar());
+        else
+        {
+            qCWarning(KALARM_LOG) << "Error parsing dropped calendar";
+            QMimeData fallback;
+            fallback.setUrls(urls);
+            if (!text.isEmpty())
+                fallback.setText(text);
+            if (urls.isEmpty()  &&  text.isEmpty())
+                KAMessageBox::error(window ? window.data() : mainMainWindow(), i18nc("@info", "The dropped calendar could not be read."));
+            else
+                executeDrop(window, &fallback);
+        }
+    });
+    connect(parser, &QThread::finished, parser, &QObject::deleteLater);
+    // Don't let the application exit while the thread is still running.
+    connect(qApp, &QCoreApplication::aboutToQuit, parser, [parser]() { parser->wait(); });
+    parser->start();
+}
+
+/******************************************************************************
+* Create alarms from a dropped, parsed, iCalendar.
+* If it contains several events with alarms, they are all imported at once in
+* the same way as by the Import Alarms action, ignoring any which already exist.
+* Otherwise, if it contains an event, or no events but a todo, the edit alarm
+* dialog is opened for the first one.
+*/
+void MainWindow::executeCalendarDrop(MainWindow* win, const KCalCore::Calendar::Ptr& calendar)
+{
+    Event::List events = calendar->rawEvents();
+    if (events.count() > 1)
+    {
+        int withAlarms = 0;
+        for (int i = 0, end = events.count();  i < end;  ++i)
+        {
+            if (!events[i]->alarms().isEmpty())
+                ++withAlarms;
+        }
+        if (withAlarms)
+        {
+            QWidget* parent = win ? win : mainMainWindow();
+            FileStorage::Ptr calStorage(new FileStorage(calendar));
+            int skipped, imported;
+            if (!AlarmCalendar::importCalendar(calStorage, nullptr, true, &skipped, &imported))
+                KAMessageBox::error(parent, i18nc("@info", "Error importing the dropped alarms"));
+            else
+            {
+                const int ignored = events.count() - imported - skipped;
+                qCDebug(KALARM_LOG) << "Imported" << imported << "events," << skipped << "already existed," << ignored << "ignored";
+                QStringList text;
+                text += i18ncp("@info", "1 alarm was imported.", "%1 alarms were imported.", imported);
+                if (skipped)
+                    text += i18ncp("@info", "1 alarm already existed and was skipped.", "%1 alarms already existed and were skipped.", skipped);
+                if (ignored)
+                    text += i18ncp("@info", "1 event could not be used as an alarm.", "%1 events could not be used as alarms.", ignored);
+                KAMessageBox::information(parent, text.join(QLatin1Char('\n')));
+            }
+            return;
+        }
+    }
+    // If an event is included, use it
+    if (!events.isEmpty())
+    {
+        KAEvent ev(events[0]);
+        KAlarm::editNewAlarm(&ev, win);
+        return;
+    }
+    // If todos are included, use the first todo
+    Todo::List todos = calendar->rawTodos();
+    if (todos.isEmpty())
+        return;
+    Todo::Ptr todo = todos[0];
+    AlarmText alarmText;
+    alarmText.setTodo(todo);
+    KDateTime start = q2k(todo->dtStart(true), todo->allDay());
+    if (!start.isValid()  &&  todo->hasDueDate())
+        start = q2k(todo->dtDue(true), todo->allDay());
+    KAEvent::Flags flags = KAEvent::DEFAULT_FONT;
+    if (start.isDateOnly())
+        flags |= KAEvent::ANY_TIME;
+    KAEvent ev(start, alarmText.displayText(), Preferences::defaultBgColour(), Preferences::defaultFgColour(),
+               QFont(), KAEvent::MESSAGE, 0, flags, true);
+    if (todo->recurs())
+    {
+        ev.setRecurrence(*todo->recurrence());
+        ev.setNextOccurrence(KDateTime::currentUtcDateTime());
+    }
+    ev.endChanges();
+    KAlarm::editNewAlarm(&ev, win);
+}
+
 /******************************************************************************
 * Called when an object is dropped on a main or system tray window, to
 * evaluate the action required and extract the text.
 */
 void MainWindow::executeDropEvent(MainWindow* win, QDropEvent* e)
 {
-    qCDebug(KALARM_LOG) << "Formats:" << e->mimeData()->formats();
-    const QMimeData* data = e->mimeData();
+    executeDrop(win, e->mimeData());
+}
+
+/******************************************************************************
+* Create an alarm from dropped data.
+*/
+void MainWindow::executeDrop(MainWindow* win, const QMimeData* data)
+{
+    qCDebug(KALARM_LOG) << "Formats:" << data->formats();
     KAEvent::SubAction action = KAEvent::MESSAGE;
     QByteArray         bytes;
     AlarmText          alarmText;
     KPIM::MailList     mailList;
     QList<QUrl>        files;
-    MemoryCalendar::Ptr calendar(new MemoryCalendar(Preferences::qTimeZone(true)));
 #ifndef NDEBUG
     QString fmts = data->formats().join(QStringLiteral(", "));
     qCDebug(KALARM_LOG) << fmts;
@@ -1324,38 +1529,12 @@ void MainWindow::executeDropEvent(MainWindow* win, QDropEvent* e)
                            KLocale::global()->formatDateTime(dt), summary.subject(),
                            body, summary.serialNumber());
     }
-    else if (ICalDrag::fromMimeData(data, calendar))
+    else if (ICalDrag::canDecode(data))
     {
-        // iCalendar - If events are included, use the first event
+        // iCalendar - parse it asynchronously, since it may contain a large
+        // number of events.
         qCDebug(KALARM_LOG) << "iCalendar";
-        Event::List events = calendar->rawEvents();
-        if (!events.isEmpty())
-        {
-            KAEvent ev(events[0]);
-            KAlarm::editNewAlarm(&ev, win);
-            return;
-        }
-        // If todos are included, use the first todo
-        Todo::List todos = calendar->rawTodos();
-        if (todos.isEmpty())
-            return;
-        Todo::Ptr todo = todos[0];
-        alarmText.setTodo(todo);
-        KDateTime start = q2k(todo->dtStart(true), todo->allDay());
-        if (!start.isValid()  &&  todo->hasDueDate())
-            start = q2k(todo->dtDue(true), todo->allDay());
-        KAEvent::Flags flags = KAEvent::DEFAULT_FONT;
-        if (start.isDateOnly())
-            flags |= KAEvent::ANY_TIME;
-        KAEvent ev(start, alarmText.displayText(), Preferences::defaultBgColour(), Preferences::defaultFgColour(),
-                   QFont(), KAEvent::MESSAGE, 0, flags, true);
-        if (todo->recurs())
-        {
-            ev.setRecurrence(*todo->recurrence());
-            ev.setNextOccurrence(KDateTime::currentUtcDateTime());
-        }
-        ev.endChanges();
-        KAlarm::editNewAlarm(&ev, win);
+        parseDroppedCalendar(win, data->data(ICalDrag::mimeType()), data->urls(), (data->hasText() ? data->text() : QString()));
         return;
     }
     else if (!(files = data->urls()).isEmpty())
@@ -1429,7 +1608,7 @@ void MainWindow::slotCalendarStatusChanged()
 void MainWindow::slotSelection()
 {
     // Find which events have been selected
-    QVector<KAEvent> events = mListView->selectedEvents();
+    const KAEvent::List events = selectedCalendarEvents();
     int count = events.count();
     if (!count)
     {
@@ -1451,12 +1630,11 @@ void MainWindow::slotSelection()
     KDateTime now = KDateTime::currentUtcDateTime();
     for (int i = 0;  i < count;  ++i)
     {
-        KAEvent* ev = resources->event(EventId(events[i]));   // get up-to-date status
-        KAEvent* event = ev ? ev : &events[i];
+        const KAEvent* event = events[i];
         bool expired = event->expired();
         if (!expired)
             allArchived = false;
-        if (resources->eventReadOnly(event->itemId()))
+        if (resources->eventReadOnly(*event))
             readOnly = true;
         if (enableReactivate
         &&  (!expired  ||  !event->occursAfter(now, true)))
@@ -40,6 +40,8 @@ class QHideEvent;
 class QShowEvent;
 class QResizeEvent;
 class QDropEvent;
+class QMimeData;
+class QUrl;
 class QCloseEvent;
 class QSplitter;
 class QMenu;
@@ -157,11 +159,16 @@ class MainWindow : public MainWindowBase, public KCalCore::Calendar::CalendarObs
         void           initActions();
         void           initCalendarResources();
         void           selectionCleared();
+        KAEvent::List  selectedCalendarEvents() const;
         void           setEnableText(bool enable);
         void           initUndoMenu(QMenu*, Undo::Type);
         void           slotDelete(bool force);
         static KAEvent::SubAction  getDropAction(QDropEvent*, QString& text);
+        static void    executeDrop(MainWindow*, const QMimeData*);
+        static void    parseDroppedCalendar(MainWindow*, const QByteArray& icalData, const QList<QUrl>& urls, const QString& text);
+        static void    executeCalendarDrop(MainWindow*, const KCalCore::Calendar::Ptr&);
         static void    setUpdateTimer();
+        static void    checkTimeToDisplayed();
         static void    enableTemplateMenuItem(bool);
 
         static WindowList    mWindowList;   // active main windows
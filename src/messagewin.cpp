@@ -24,6 +24,7 @@
 #include "messagewin.h"
 
 #include "alarmcalendar.h"
+#include "alarminbox.h"
 #include "autoqpointer.h"
 #include "collectionmodel.h"
 #include "deferdlg.h"
@@ -107,6 +108,8 @@ static const QLatin1String KMAIL_DBUS_PATH("/KMail");
 // configured, i.e. the windows are placed far from the cursor.
 static const int proximityButtonDelay = 1000;    // (milliseconds)
 static const int proximityMultiple = 10;         // multiple of button height distance from cursor for proximity
+static const int MAX_PREPARED_WINDOWS = 5;       // maximum number of windows prepared in advance
+static const int PREPARED_EXPIRY = 60;           // seconds after trigger time to discard an unused prepared window
 
 // A text label widget which can be scrolled and copied with the mouse
 class MessageText : public KTextEdit
@@ -154,13 +157,20 @@ enum {
 
 
 QList<MessageWin*> MessageWin::mWindowList;
+QList<MessageWin*> MessageWin::mPreparedWindows;
+QList<MessageWin*> MessageWin::mPreActionWindows;
 QMap<EventId, unsigned> MessageWin::mErrorMessages;
 bool                    MessageWin::mRedisplayed = false;
-// There can only be one audio thread at a time: trying to play multiple
-// sound files simultaneously would result in a cacophony, and besides
-// that, Phonon currently crashes...
-QPointer<AudioThread> MessageWin::mAudioThread;
-MessageWin*           AudioThread::mAudioOwner = nullptr;
+// Sound files for simultaneous alarms are played concurrently, up to the limit
+// set by Preferences::maxConcurrentSounds(). Any more are queued until one of
+// those playing finishes, to avoid a cacophony. A repeating sound stops at the
+// end of its current play (or pause) to let a queued sound play, and is then
+// queued to resume afterwards, so that it cannot hold up other alarms.
+// Note that Phonon has been known to crash when multiple audio threads play
+// simultaneously, so the limit defaults to 1.
+QList<QPointer<MessageWin> > MessageWin::mAudioQueue;
+QList<AudioThread*>     AudioThread::mInstances;
+SpeechQueue*            SpeechQueue::mInstance = nullptr;
 
 /******************************************************************************
 * Construct the message window for the specified alarm.
@@ -169,7 +179,7 @@ MessageWin*           AudioThread::mAudioOwner = nullptr;
 * displayed.
 */
 MessageWin::MessageWin(const KAEvent* event, const KAAlarm& alarm, int flags)
-    : MainWindowBase(nullptr, static_cast<Qt::WindowFlags>(WFLAGS | WFLAGS2 | ((flags & ALWAYS_HIDE) || getWorkAreaAndModal() ? Qt::WindowType(0) : Qt::X11BypassWindowManagerHint))),
+    : MainWindowBase(nullptr, static_cast<Qt::WindowFlags>(WFLAGS | WFLAGS2 | ((flags & ALWAYS_HIDE) || getWorkAreaAndModal() || (flags & PRE_ACTION) ? Qt::WindowType(0) : Qt::X11BypassWindowManagerHint))),
       mMessage(event->cleanText()),
       mFont(event->font()),
       mBgColour(event->bgColour()),
@@ -200,11 +210,13 @@ MessageWin::MessageWin(const KAEvent* event, const KAAlarm& alarm, int flags)
       mSilenceButton(nullptr),
       mKMailButton(nullptr),
       mCommandText(nullptr),
+      mPreActionText(nullptr),
       mDontShowAgainCheck(nullptr),
       mEditDlg(nullptr),
       mDeferDlg(nullptr),
       mAlwaysHide(flags & ALWAYS_HIDE),
       mErrorWindow(false),
+      mPreAction(flags & PRE_ACTION),
       mInitialised(false),
       mNoPostAction(alarm.type() & KAAlarm::REMINDER_ALARM),
       mRecreating(false),
@@ -233,7 +245,9 @@ MessageWin::MessageWin(const KAEvent* event, const KAAlarm& alarm, int flags)
     }
     else
         mDateTime = alarm.dateTime(true);
-    if (!(flags & (NO_INIT_VIEW | ALWAYS_HIDE)))
+    if (mPreAction)
+        initPreActionView();
+    else if (!(flags & (NO_INIT_VIEW | ALWAYS_HIDE)))
     {
         const bool readonly = AlarmCalendar::resources()->eventReadOnly(mEventItemId);
         mShowEdit = !mEventId.isEmpty()  &&  !readonly;
@@ -243,7 +257,12 @@ MessageWin::MessageWin(const KAEvent* event, const KAAlarm& alarm, int flags)
     // Set to save settings automatically, but don't save window size.
     // File alarm window size is saved elsewhere.
     setAutoSaveSettings(QStringLiteral("MessageWin"), false);
-    mWindowList.append(this);
+    if (flags & PREPARE)
+        mPreparedWindows.append(this);   // not displayed until takePrepared() is called
+    else if (mPreAction)
+        mPreActionWindows.append(this);  // replaced when the pre-alarm action completes
+    else
+        mWindowList.append(this);
     if (event->autoClose())
         mCloseTime = alarm.dateTime().effectiveKDateTime().toUtc().dateTime().addSecs(event->lateCancel() * 60);
     if (mAlwaysHide)
@@ -309,11 +328,13 @@ MessageWin::MessageWin(const KAEvent* event, const DateTime& alarmDateTime,
       mSilenceButton(nullptr),
       mKMailButton(nullptr),
       mCommandText(nullptr),
+      mPreActionText(nullptr),
       mDontShowAgainCheck(nullptr),
       mEditDlg(nullptr),
       mDeferDlg(nullptr),
       mAlwaysHide(false),
       mErrorWindow(true),
+      mPreAction(false),
       mInitialised(false),
       mNoPostAction(true),
       mRecreating(false),
@@ -345,11 +366,13 @@ MessageWin::MessageWin()
       mSilenceButton(nullptr),
       mKMailButton(nullptr),
       mCommandText(nullptr),
+      mPreActionText(nullptr),
       mDontShowAgainCheck(nullptr),
       mEditDlg(nullptr),
       mDeferDlg(nullptr),
       mAlwaysHide(false),
       mErrorWindow(false),
+      mPreAction(false),
       mInitialised(false),
       mRecreating(false),
       mRescheduleEvent(false),
@@ -372,11 +395,15 @@ MessageWin::MessageWin()
 MessageWin::~MessageWin()
 {
     qCDebug(KALARM_LOG) << (void*)this << mEventId;
-    if (AudioThread::mAudioOwner == this  &&  !mAudioThread.isNull())
+    if (!mAudioThread.isNull())
         mAudioThread->quit();
-    mErrorMessages.remove(mEventId);
+    mAudioQueue.removeAll(this);
+    if (!mPreAction)
+        mErrorMessages.remove(mEventId);
     mWindowList.removeAll(this);
-    if (!mRecreating)
+    const bool prepared = mPreparedWindows.removeAll(this);
+    mPreActionWindows.removeAll(this);
+    if (!mRecreating  &&  !prepared  &&  !mPreAction)
     {
         if (!mNoPostAction  &&  !mEvent.postAction().isEmpty())
             theApp()->alarmCompleted(mEvent);
@@ -768,6 +795,54 @@ void MessageWin::initView()
     mInitialised = true;   // the window's widgets have been created
 }
 
+/******************************************************************************
+* Construct the window's widgets for a window which shows the progress of the
+* alarm's pre-alarm action. The alarm message itself is displayed in a new
+* window once the pre-alarm action has completed.
+*/
+void MessageWin::initPreActionView()
+{
+    setCaption((mAlarmType & KAAlarm::REMINDER_ALARM) ? i18nc("@title:window", "Reminder") : i18nc("@title:window", "Message"));
+    QWidget* topWidget = new QWidget(this);
+    setCentralWidget(topWidget);
+    QVBoxLayout* topLayout = new QVBoxLayout(topWidget);
+    topLayout->setMargin(style()->pixelMetric(QStyle::PM_DefaultChildMargin));
+    topLayout->setSpacing(style()->pixelMetric(QStyle::PM_DefaultLayoutSpacing));
+
+    QPalette labelPalette = palette();
+    labelPalette.setColor(backgroundRole(), labelPalette.color(QPalette::Window));
+
+    mTimeLabel = new QLabel(topWidget);
+    mTimeLabel->setText(dateTimeToDisplay());
+    mTimeLabel->setFrameStyle(QFrame::StyledPanel);
+    mTimeLabel->setPalette(labelPalette);
+    mTimeLabel->setAutoFillBackground(true);
+    topLayout->addWidget(mTimeLabel, 0, Qt::AlignHCenter);
+    if (!mDateTime.isValid())
+        mTimeLabel->hide();
+
+    QLabel* label = new QLabel(i18nc("@info", "Preparing alarm..."), topWidget);
+    topLayout->addWidget(label, 0, Qt::AlignHCenter);
+    label->setWhatsThis(i18nc("@info:whatsthis", "The alarm will be displayed once its pre-alarm action has completed."));
+
+    mPreActionText = new MessageText(topWidget);
+    mPreActionText->setBackgroundColour(mBgColour);
+    mPreActionText->setTextColor(mFgColour);
+    mPreActionText->setCurrentFont(mFont);
+    topLayout->addWidget(mPreActionText);
+    mPreActionText->setWhatsThis(i18nc("@info:whatsthis", "The output of the alarm's pre-alarm action"));
+    mPreActionText->hide();    // shown once there is some output
+
+    // Close button, in case the pre-alarm action takes a long time
+    PushButton* button = new PushButton(KStandardGuiItem::close(), topWidget);
+    button->clearFocus();
+    button->setFocusPolicy(Qt::ClickFocus);    // don't allow keyboard selection
+    button->setFixedSize(button->sizeHint());
+    connect(button, &QAbstractButton::clicked, this, &QWidget::close);
+    topLayout->addWidget(button, 0, Qt::AlignRight);
+    button->setWhatsThis(i18nc("@info:whatsthis", "Close this window. The alarm will still be displayed when its pre-alarm action completes."));
+}
+
 /******************************************************************************
 * Return the number of message windows, optionally excluding always-hidden ones.
 */
@@ -942,6 +1017,25 @@ void MessageWin::readProcessOutput(ShellProcess* proc)
     }
 }
 
+/******************************************************************************
+* Called when output is available from the pre-alarm action whose progress is
+* shown in this window. Add the output and resize the window to show it.
+*/
+void MessageWin::readPreActionOutput(ShellProcess* proc)
+{
+    const QByteArray data = proc->readAll();
+    if (!data.isEmpty())
+    {
+        if (mPreActionText->newLine())
+            mPreActionText->append(QStringLiteral("\n"));
+        const int nl = data.endsWith('\n') ? 1 : 0;
+        mPreActionText->setNewLine(nl);
+        mPreActionText->insertPlainText(QString::fromLocal8Bit(data.data(), data.length() - nl));
+        mPreActionText->show();
+        resize(sizeHint());
+    }
+}
+
 /******************************************************************************
 * Save settings to the session managed config file, for restoration
 * when the program is restored.
@@ -1158,12 +1252,19 @@ void MessageWin::redisplayAlarms()
                 }
                 qCDebug(KALARM_LOG) << eventId;
                 const bool login = alarm.repeatAtLogin();
+                const bool rw = CollectionControlModel::isWritableEnabled(collection, event.category()) > 0;
+                const bool noDefer = (rw && !login) ? !showDefer : true;
+                if (AlarmInbox::contains(eventId)  ||  AlarmInbox::wanted(alarm))
+                {
+                    // Too many alarms are displayed, so show it in the alarm inbox
+                    AlarmInbox::addAlarm(event, alarm, NO_RESCHEDULE | (noDefer ? NO_DEFER : 0), true);
+                    continue;
+                }
                 const int flags = NO_RESCHEDULE | (login ? NO_DEFER : 0) | NO_INIT_VIEW;
                 MessageWin* win = new MessageWin(&event, alarm, flags);
                 win->mCollection = collection;
-                const bool rw = CollectionControlModel::isWritableEnabled(collection, event.category()) > 0;
                 win->mShowEdit = rw ? showEdit : false;
-                win->mNoDefer  = (rw && !login) ? !showDefer : true;
+                win->mNoDefer  = noDefer;
                 win->initView();
                 win->show();
             }
@@ -1171,6 +1272,195 @@ void MessageWin::redisplayAlarms()
     }
 }
 
+/******************************************************************************
+* Prepare a hidden message window in advance for an alarm which is due to
+* trigger shortly, so that the window can be displayed with minimal delay when
+* the alarm triggers.
+* The window is only prepared for message and file display alarms. Command
+* output alarms are excluded since the command must not be executed early.
+* If the alarm is to be spoken, the text-to-speech engine is also initialised.
+*/
+void MessageWin::prepare(const KAEvent& event)
+{
+    if (event.speak())
+        SpeechQueue::warmUp();
+
+    // Discard any prepared windows which were never used and whose expiry
+    // timers have not yet fired (e.g. after the system has been suspended)
+    const KDateTime now = KDateTime::currentUtcDateTime();
+    for (int i = mPreparedWindows.count();  --i >= 0;  )
+    {
+        if (mPreparedWindows[i]->mPreparedTrigger.secsTo(now) > PREPARED_EXPIRY)
+            delete mPreparedWindows[i];
+    }
+
+    if (!event.enabled()  ||  event.workTimeOnly()  ||  event.holidaysExcluded()
+    ||  mPreparedWindows.count() >= MAX_PREPARED_WINDOWS)
+        return;
+    const EventId eventId(event);
+    if (findEvent(eventId))
+        return;   // execAlarm() will use the existing window
+    for (int i = 0, end = mPreparedWindows.count();  i < end;  ++i)
+    {
+        if (mPreparedWindows[i]->mEventId == eventId)
+            return;   // already prepared
+    }
+
+    // Find the alarm which will be executed when the event triggers
+    const KDateTime nextDt = event.nextTrigger(KAEvent::ALL_TRIGGER).effectiveKDateTime();
+    for (KAAlarm alarm = event.firstAlarm();  alarm.isValid();  alarm = event.nextAlarm(alarm))
+    {
+        const KDateTime dt = alarm.dateTime(true).effectiveKDateTime();
+        if (dt > nextDt)
+            continue;
+        if ((alarm.action() != KAAlarm::MESSAGE  &&  alarm.action() != KAAlarm::FILE)
+        ||  alarm.repeatAtLogin())
+            return;
+        qCDebug(KALARM_LOG) << eventId << ", alarm" << alarm.type() << "at" << dt.dateTime();
+        MessageWin* win = new MessageWin(&event, alarm, PREPARE);
+        win->mPreparedTrigger = dt;
+        connect(AkonadiModel::instance(), &AkonadiModel::eventChanged, win, &MessageWin::slotPreparedEventChanged);
+        connect(AkonadiModel::instance(), &AkonadiModel::eventsToBeRemoved, win, &MessageWin::slotPreparedEventsRemoved);
+        // Discard the window if it is still unused shortly after the trigger
+        // time, e.g. because the alarm was routed to the inbox instead.
+        const int expirySecs = qMax(static_cast<int>(now.secsTo(dt)), 0) + PREPARED_EXPIRY;
+        QTimer::singleShot(expirySecs * 1000, win, &MessageWin::slotPreparedExpired);
+
+        // Lay out the window and create its native window, without mapping it.
+        win->ensurePolished();
+        if (win->layout())
+            win->layout()->activate();
+        win->resize(win->sizeHint());
+        win->winId();
+        return;
+    }
+}
+
+/******************************************************************************
+* Return the window prepared in advance for an alarm, if any, and make it a
+* normal message window ready to be shown.
+* If the prepared window doesn't match the alarm now being executed, it is
+* discarded and null is returned.
+*/
+MessageWin* MessageWin::takePrepared(const KAEvent& event, const KAAlarm& alarm, int flags)
+{
+    const EventId eventId(event);
+    for (int i = 0, end = mPreparedWindows.count();  i < end;  ++i)
+    {
+        MessageWin* win = mPreparedWindows[i];
+        if (win->mEventId == eventId)
+        {
+            if (flags
+            ||  win->mAlarmType != alarm.type()
+            ||  win->mPreparedTrigger != alarm.dateTime(true).effectiveKDateTime())
+            {
+                qCDebug(KALARM_LOG) << eventId << ": discarding mismatched window";
+                delete win;
+                return nullptr;
+            }
+            qCDebug(KALARM_LOG) << eventId;
+            mPreparedWindows.removeAt(i);
+            disconnect(AkonadiModel::instance(), nullptr, win, nullptr);
+            // Other alarms in the event may have been updated by the caller,
+            // so store the latest version of the event.
+            win->mEvent         = event;
+            win->mOriginalEvent = event;
+            mWindowList.append(win);
+            return win;
+        }
+    }
+    return nullptr;
+}
+
+/******************************************************************************
+* Discard all windows prepared in advance.
+*/
+void MessageWin::discardPrepared()
+{
+    qDeleteAll(QList<MessageWin*>(mPreparedWindows));
+}
+
+/******************************************************************************
+* Display a window showing that an alarm's pre-alarm action is executing, so
+* that the user sees the alarm immediately instead of only when the pre-alarm
+* action has completed. The output from the pre-alarm action is shown as it is
+* received. The window is removed by endPreAction(), or may be closed by the
+* user. It is never shown bypassing the window manager, so that the user can
+* always move or close it.
+*/
+void MessageWin::showPreAction(const KAEvent& event, const KAAlarm& alarm, ShellProcess* proc)
+{
+    qCDebug(KALARM_LOG) << EventId(event);
+    MessageWin* win = new MessageWin(&event, alarm, PRE_ACTION);
+    connect(proc, &ShellProcess::receivedStdout, win, &MessageWin::readPreActionOutput);
+    connect(proc, &ShellProcess::receivedStderr, win, &MessageWin::readPreActionOutput);
+    // Position the window in the middle of the screen. (showEvent() doesn't
+    // position it, since it isn't a full alarm message window.)
+    win->resize(win->sizeHint());
+    const QRect desk = KAlarm::desktopWorkArea(win->mScreenNumber);
+    win->move(desk.x() + (desk.width() - win->width())/2, desk.y() + (desk.height() - win->height())/2);
+    win->MainWindowBase::show();
+}
+
+/******************************************************************************
+* Remove the window showing the progress of an alarm's pre-alarm action.
+*/
+void MessageWin::endPreAction(const EventId& eventId)
+{
+    for (int i = mPreActionWindows.count();  --i >= 0;  )
+    {
+        if (mPreActionWindows[i]->mEventId == eventId)
+            delete mPreActionWindows[i];
+    }
+}
+
+/******************************************************************************
+* Called when an event in the calendar has changed.
+* If this is a prepared window for the event, discard it since it may now be
+* out of date.
+*/
+void MessageWin::slotPreparedEventChanged(const AkonadiModel::Event& event)
+{
+    if (EventId(event.event) == mEventId)
+    {
+        mPreparedWindows.removeAll(this);
+        mRecreating = true;   // prevent any post-alarm action
+        deleteLater();
+    }
+}
+
+/******************************************************************************
+* Called when events are about to be removed from the calendar.
+* If this is a prepared window for one of the events, discard it.
+*/
+void MessageWin::slotPreparedEventsRemoved(const AkonadiModel::EventList& events)
+{
+    for (int i = 0, end = events.count();  i < end;  ++i)
+    {
+        if (EventId(events[i].event) == mEventId)
+        {
+            mPreparedWindows.removeAll(this);
+            mRecreating = true;   // prevent any post-alarm action
+            deleteLater();
+            return;
+        }
+    }
+}
+
+/******************************************************************************
+* Called when a prepared window has not been used by PREPARED_EXPIRY seconds
+* after its alarm's trigger time. Discard it if it is still unused.
+*/
+void MessageWin::slotPreparedExpired()
+{
+    if (mPreparedWindows.removeAll(this))
+    {
+        qCDebug(KALARM_LOG) << mEventId << ": discarding unused window";
+        mRecreating = true;   // prevent any post-alarm action
+        deleteLater();
+    }
+}
+
 /******************************************************************************
 * Retrieves the event with the current ID from the displaying calendar file,
 * or if not found there, from the archive calendar.
@@ -1357,6 +1647,7 @@ void MessageWin::playAudio()
     {
         if (!mVolume  &&  mFadeVolume <= 0)
             return;    // ensure zero volume doesn't play anything
+        mAudioLatency.start();
         startAudio();    // play the audio file
     }
     else if (mSpeak)
@@ -1373,70 +1664,103 @@ void MessageWin::playAudio()
 */
 void MessageWin::slotSpeak()
 {
-    KPIMTextEdit::TextToSpeech *tts = KPIMTextEdit::TextToSpeech::self();
-    if (!tts->isReady()) {
-        KAMessageBox::detailedError(MainWindow::mainMainWindow(), i18nc("@info", "Unable to speak message"), i18nc("@info", "Text-to-speech subsystem is not available"));
-        clearErrorMessage(ErrMsg_Speak);
-        return;
-    }
-
-    tts->say(mMessage);
+    SpeechQueue::instance()->say(mMessage);
 }
 
 /******************************************************************************
-* Called when another window's audio thread has been destructed.
 * Start playing this window's audio file. Because initialising the sound system
 * and loading the file may take some time, it is called in a separate thread to
 * allow the window to display first.
+* If the maximum number of audio files are already playing for other message
+* windows, the window is queued until one of them has finished.
 */
 void MessageWin::startAudio()
 {
     if (mAudioThread)
+        return;   // already playing
+    if (AudioThread::mInstances.count() >= Preferences::maxConcurrentSounds())
     {
-        // An audio file is already playing for another message
-        // window, so wait until it has finished.
-        connect(mAudioThread.data(), &QObject::destroyed, this, &MessageWin::audioTerminating);
+        if (!mAudioQueue.contains(this))
+        {
+            qCDebug(KALARM_LOG) << "Queued:" << mEventId << ", queue length:" << mAudioQueue.count() + 1;
+            mAudioQueue.append(this);
+            // Let the longest playing repeating sound make way for this one.
+            for (AudioThread* thread : qAsConst(AudioThread::mInstances))
+            {
+                if (thread->yield())
+                    break;
+            }
+            // Notify so that the Stop Play action can clear the queue.
+            theApp()->notifyAudioPlaying(true);
+        }
+        return;
     }
-    else
+    mAudioQueue.removeAll(this);
+
+    qCDebug(KALARM_LOG) << QThread::currentThread() << mEventId;
+    mAudioThread = new AudioThread(this, mAudioFile, mVolume, mFadeVolume, mFadeSeconds, mAudioRepeatPause);
+    connect(mAudioThread.data(), &AudioThread::readyToPlay, this, &MessageWin::playReady);
+    connect(mAudioThread.data(), &QThread::finished, this, &MessageWin::playFinished);
+    if (mSilenceButton)
+        connect(mSilenceButton, &QAbstractButton::clicked, mAudioThread.data(), [this]() { stopWindowAudio(); });
+    // Notify after creating mAudioThread, so that isAudioPlaying() will
+    // return the correct value.
+    theApp()->notifyAudioPlaying(true);
+    mAudioThread->start();
+}
+
+/******************************************************************************
+* Called after an audio thread has been destructed.
+* Start playing the audio files of as many queued windows as the concurrency
+* limit allows, in the order in which they were queued.
+*/
+void MessageWin::startQueuedAudio()
+{
+    while (!mAudioQueue.isEmpty()
+       &&  AudioThread::mInstances.count() < Preferences::maxConcurrentSounds())
     {
-        qCDebug(KALARM_LOG) << QThread::currentThread();
-        mAudioThread = new AudioThread(this, mAudioFile, mVolume, mFadeVolume, mFadeSeconds, mAudioRepeatPause);
-        connect(mAudioThread.data(), &AudioThread::readyToPlay, this, &MessageWin::playReady);
-        connect(mAudioThread.data(), &QThread::finished, this, &MessageWin::playFinished);
-        if (mSilenceButton)
-            connect(mSilenceButton, &QAbstractButton::clicked, mAudioThread.data(), &QThread::quit);
-        // Notify after creating mAudioThread, so that isAudioPlaying() will
-        // return the correct value.
-        theApp()->notifyAudioPlaying(true);
-        mAudioThread->start();
+        MessageWin* win = mAudioQueue.takeFirst();
+        if (win)
+            win->startAudio();
     }
+    AlarmInbox::playPendingAudio();
+    if (!isAudioPlaying())
+        theApp()->notifyAudioStopped();
 }
 
 /******************************************************************************
-* Return whether audio playback is currently active.
+* Return whether audio playback is currently active or queued.
 */
 bool MessageWin::isAudioPlaying()
 {
-    return mAudioThread;
+    return !AudioThread::mInstances.isEmpty()  ||  !mAudioQueue.isEmpty();
 }
 
 /******************************************************************************
-* Stop audio playback.
+* Stop all audio playback, and discard any queued audio files.
 */
 void MessageWin::stopAudio(bool wait)
 {
     qCDebug(KALARM_LOG);
-    if (mAudioThread)
-        mAudioThread->stop(wait);
+    mAudioQueue.clear();
+    AlarmInbox::clearPendingAudio();
+    const QList<AudioThread*> threads = AudioThread::mInstances;
+    for (AudioThread* thread : threads)
+        thread->stop(wait);
 }
 
 /******************************************************************************
-* Called when another window's audio thread is being destructed.
-* Wait until the destructor has finished.
+* Stop this window's audio playback, or remove it from the queue if it is
+* waiting to play. Other windows' audio is unaffected.
 */
-void MessageWin::audioTerminating()
+void MessageWin::stopWindowAudio(bool wait)
 {
-    QTimer::singleShot(0, this, &MessageWin::startAudio);
+    qCDebug(KALARM_LOG) << mEventId;
+    mAudioQueue.removeAll(this);
+    if (mAudioThread)
+        mAudioThread->stop(wait);
+    else if (!isAudioPlaying())
+        theApp()->notifyAudioStopped();
 }
 
 /******************************************************************************
@@ -1444,17 +1768,21 @@ void MessageWin::audioTerminating()
 */
 void MessageWin::playReady()
 {
+    qCDebug(KALARM_LOG) << mEventId << "start latency:" << mAudioLatency.elapsed() << "ms";
     if (mSilenceButton)
         mSilenceButton->setEnabled(true);
 }
 
 /******************************************************************************
 * Called when the audio file thread finishes.
+* If a repeating sound stopped to let a queued sound play, queue it to resume
+* once the sounds ahead of it have played.
 */
 void MessageWin::playFinished()
 {
     if (mSilenceButton)
         mSilenceButton->setEnabled(false);
+    bool resume = false;
     if (mAudioThread)   // mAudioThread can actually be null here!
     {
         const QString errmsg = mAudioThread->error();
@@ -1463,8 +1791,16 @@ void MessageWin::playFinished()
             KAMessageBox::error(this, errmsg);
             clearErrorMessage(ErrMsg_AudioFile);
         }
+        resume = errmsg.isEmpty()  &&  mAudioThread->yielded();
     }
     delete mAudioThread.data();
+    if (resume)
+    {
+        qCDebug(KALARM_LOG) << "Requeued:" << mEventId;
+        mAudioLatency.start();
+        mAudioQueue.append(this);   // started by startQueuedAudio()
+        return;
+    }
     if (mAlwaysHide)
         close();
 }
@@ -1472,18 +1808,17 @@ void MessageWin::playFinished()
 /******************************************************************************
 * Constructor for audio thread.
 */
-AudioThread::AudioThread(MessageWin* parent, const QString& audioFile, float volume, float fadeVolume, int fadeSeconds, int repeatPause)
+AudioThread::AudioThread(QObject* parent, const QString& audioFile, float volume, float fadeVolume, int fadeSeconds, int repeatPause)
     : QThread(parent),
       mFile(audioFile),
       mVolume(volume),
       mFadeVolume(fadeVolume),
       mFadeSeconds(fadeSeconds),
       mRepeatPause(repeatPause),
-      mAudioObject(nullptr)
+      mAudioObject(nullptr),
+      mYield(false)
 {
-    if (mAudioOwner)
-        qCCritical(KALARM_LOG) << "mAudioOwner already set";
-    mAudioOwner = parent;
+    mInstances.append(this);
 }
 
 /******************************************************************************
@@ -1496,11 +1831,11 @@ AudioThread::~AudioThread()
     stop(true);   // stop playing and tidy up (timeout 3 seconds)
     delete mAudioObject;
     mAudioObject = nullptr;
-    if (mAudioOwner == parent())
-        mAudioOwner = nullptr;
-    // Notify after deleting mAudioThread, so that isAudioPlaying() will
-    // return the correct value.
-    QTimer::singleShot(0, theApp(), &KAlarmApp::notifyAudioStopped);
+    mInstances.removeAll(this);
+    // Start any queued audio, and notify if all audio has stopped, after
+    // this thread has been deleted so that isAudioPlaying() will return
+    // the correct value.
+    QTimer::singleShot(0, theApp(), &MessageWin::startQueuedAudio);
 }
 
 /******************************************************************************
@@ -1509,6 +1844,9 @@ AudioThread::~AudioThread()
 void AudioThread::stop(bool waiT)
 {
     qCDebug(KALARM_LOG);
+    mMutex.lock();
+    mYield = false;   // the sound has been stopped, so must not resume
+    mMutex.unlock();
     quit();       // stop playing and tidy up
     wait(3000);   // wait for run() to exit (timeout 3 seconds)
     if (!isFinished())
@@ -1592,13 +1930,22 @@ void AudioThread::checkAudioPlay()
         return;
     }
     if (mPausing)
+    {
         mPausing = false;
+        if (mYield)
+        {
+            // Another sound is waiting, so don't repeat
+            mMutex.unlock();
+            stopPlay();
+            return;
+        }
+    }
     else
     {
         // The file has loaded and is ready to play, or play has completed
         if (mPlayedOnce)
         {
-            if (mRepeatPause < 0)
+            if (mRepeatPause < 0  ||  mYield)
             {
                 // Play has completed
                 mMutex.unlock();
@@ -1665,12 +2012,164 @@ void AudioThread::stopPlay()
     quit();   // exit the event loop, if it's still running
 }
 
+/******************************************************************************
+* Called when another sound is queued waiting for this one to finish.
+* If this sound repeats, stop once the current play completes, or now if it is
+* pausing between repeats.
+* Reply = true if this sound will stop to let the other play,
+*       = false if it doesn't repeat, or is already due to stop.
+*/
+bool AudioThread::yield()
+{
+    QMutexLocker locker(&mMutex);
+    if (mRepeatPause < 0  ||  mYield)
+        return false;
+    qCDebug(KALARM_LOG) << mFile;
+    mYield = true;
+    if (mPausing)
+        quit();   // exit the event loop, which stops play
+    return true;
+}
+
+/******************************************************************************
+* Return whether this sound stopped repeating to let another sound play.
+*/
+bool AudioThread::yielded() const
+{
+    QMutexLocker locker(&mMutex);
+    return mYield;
+}
+
 QString AudioThread::error() const
 {
     QMutexLocker locker(&mMutex);
     return mError;
 }
 
+/******************************************************************************
+* Return the unique speech queue instance.
+*/
+SpeechQueue* SpeechQueue::instance()
+{
+    if (!mInstance)
+        mInstance = new SpeechQueue;
+    return mInstance;
+}
+
+/******************************************************************************
+* Initialise the text-to-speech engine in advance, when a spoken alarm is about
+* to trigger, so that its start-up time doesn't delay speaking the message.
+*/
+void SpeechQueue::warmUp()
+{
+    if (!mInstance)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        instance();
+        qCDebug(KALARM_LOG) << "Text-to-speech initialised in" << timer.elapsed() << "ms";
+    }
+}
+
+SpeechQueue::SpeechQueue()
+    : QObject(theApp()),
+      mWatchdog(new QTimer(this)),
+      mSpeaking(false),
+      mErrorShowing(false)
+{
+    mWatchdog->setSingleShot(true);
+    connect(mWatchdog, &QTimer::timeout, this, &SpeechQueue::utteranceDone);
+    KPIMTextEdit::TextToSpeech* tts = KPIMTextEdit::TextToSpeech::self();
+    connect(tts, &KPIMTextEdit::TextToSpeech::stateChanged, this, &SpeechQueue::stateChanged);
+}
+
+/******************************************************************************
+* Queue a message to be spoken. If the same text is already waiting to be
+* spoken, it is not queued again.
+*/
+void SpeechQueue::say(const QString& text)
+{
+    for (int i = 0, end = mQueue.count();  i < end;  ++i)
+    {
+        if (mQueue[i].text == text)
+        {
+            qCDebug(KALARM_LOG) << "Already queued";
+            return;
+        }
+    }
+    Utterance utterance;
+    utterance.text = text;
+    utterance.queued.start();
+    mQueue.enqueue(utterance);
+    if (!mSpeaking)
+        speakNext();
+}
+
+/******************************************************************************
+* Start speaking the next queued message, if nothing is currently being spoken.
+* If the text-to-speech engine is not available, all queued messages are
+* discarded and a single error message is displayed.
+*/
+void SpeechQueue::speakNext()
+{
+    if (mSpeaking  ||  mQueue.isEmpty())
+        return;
+    KPIMTextEdit::TextToSpeech* tts = KPIMTextEdit::TextToSpeech::self();
+    if (!tts->isReady())
+    {
+        qCWarning(KALARM_LOG) << "Text-to-speech not available:" << mQueue.count() << "messages discarded";
+        mQueue.clear();
+        if (!mErrorShowing)
+        {
+            mErrorShowing = true;
+            KAMessageBox::detailedError(MainWindow::mainMainWindow(), i18nc("@info", "Unable to speak message"), i18nc("@info", "Text-to-speech subsystem is not available"));
+            mErrorShowing = false;
+        }
+        return;
+    }
+    mCurrent = mQueue.dequeue();
+    qCDebug(KALARM_LOG) << "Queued for" << mCurrent.queued.elapsed() << "ms, remaining:" << mQueue.count();
+    mSpeaking = true;
+    mCurrent.started.start();
+    // Allow generously for the speaking time, in case the end is never signalled.
+    mWatchdog->start(10000 + 200 * mCurrent.text.length());
+    tts->say(mCurrent.text);
+}
+
+/******************************************************************************
+* Called when the text-to-speech engine changes state.
+*/
+void SpeechQueue::stateChanged(KPIMTextEdit::TextToSpeech::State state)
+{
+    if (!mSpeaking)
+        return;
+    switch (state)
+    {
+        case KPIMTextEdit::TextToSpeech::Ready:
+            utteranceDone();
+            break;
+        case KPIMTextEdit::TextToSpeech::BackendError:
+            qCWarning(KALARM_LOG) << "Text-to-speech error";
+            utteranceDone();
+            break;
+        default:
+            break;
+    }
+}
+
+/******************************************************************************
+* Called when the current message has been spoken, to start the next one.
+*/
+void SpeechQueue::utteranceDone()
+{
+    if (!mSpeaking)
+        return;
+    qCDebug(KALARM_LOG) << "Spoken in" << mCurrent.started.elapsed() << "ms";
+    mWatchdog->stop();
+    mSpeaking = false;
+    QTimer::singleShot(0, this, &SpeechQueue::speakNext);
+}
+
 /******************************************************************************
 * Raise the alarm window, re-output any required audio notification, and
 * reschedule the alarm in the calendar file.
@@ -1960,7 +2459,7 @@ void MessageWin::resizeEvent(QResizeEvent* re)
 void MessageWin::closeEvent(QCloseEvent* ce)
 {
     // Don't prompt or delete the alarm from the display calendar if the session is closing
-    if (!mErrorWindow  &&  !qApp->isSavingSession())
+    if (!mErrorWindow  &&  !mPreAction  &&  !qApp->isSavingSession())
     {
         if (mConfirmAck  &&  !mNoCloseConfirm)
         {
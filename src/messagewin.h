@@ -23,6 +23,7 @@
 
 /** @file messagewin.h - displays an alarm message */
 
+#include "akonadimodel.h"
 #include "autoqpointer.h"
 #include "eventid.h"
 #include "mainwindowbase.h"
@@ -36,6 +37,7 @@
 #include <QMap>
 #include <QPointer>
 #include <QDateTime>
+#include <QElapsedTimer>
 
 class QShowEvent;
 class QMoveEvent;
@@ -63,7 +65,9 @@ class MessageWin : public MainWindowBase
             NO_RESCHEDULE = 0x01,    // don't reschedule the event once it has displayed
             NO_DEFER      = 0x02,    // don't display the Defer button
             ALWAYS_HIDE   = 0x04,    // never show the window (e.g. for audio-only alarms)
-            NO_INIT_VIEW  = 0x08     // for internal MessageWin use only
+            NO_INIT_VIEW  = 0x08,    // for internal MessageWin use only
+            PREPARE       = 0x10,    // for internal MessageWin use only
+            PRE_ACTION    = 0x20     // for internal MessageWin use only
         };
 
         MessageWin();     // for session management restoration only
@@ -79,11 +83,17 @@ class MessageWin : public MainWindowBase
         void                showDateTime(const KAEvent&, const KAAlarm&);
         bool                isValid() const        { return !mInvalid; }
         bool                alwaysHidden() const   { return mAlwaysHide; }
+        void                stopWindowAudio(bool wait = false);
         virtual void        show();
         QSize               sizeHint() const override;
         static int          instanceCount(bool excludeAlwaysHidden = false);
         static MessageWin*  findEvent(const EventId& eventId, MessageWin* exclude = nullptr);
         static void         redisplayAlarms();
+        static void         prepare(const KAEvent&);
+        static MessageWin*  takePrepared(const KAEvent&, const KAAlarm&, int flags);
+        static void         discardPrepared();
+        static void         showPreAction(const KAEvent&, const KAAlarm&, ShellProcess*);
+        static void         endPreAction(const EventId&);
         static void         stopAudio(bool wait = false);
         static bool         isAudioPlaying();
         static void         showError(const KAEvent&, const DateTime& alarmDateTime, const QStringList& errmsgs,
@@ -110,7 +120,6 @@ class MessageWin : public MainWindowBase
         void                showRestoredAlarm();
         void                slotShowKMailMessage();
         void                slotSpeak();
-        void                audioTerminating();
         void                startAudio();
         void                playReady();
         void                playFinished();
@@ -119,11 +128,18 @@ class MessageWin : public MainWindowBase
         void                setRemainingTextMinute();
         void                frameDrawn();
         void                readProcessOutput(ShellProcess*);
+        void                readPreActionOutput(ShellProcess*);
+        void                slotPreparedEventChanged(const AkonadiModel::Event&);
+        void                slotPreparedEventsRemoved(const AkonadiModel::EventList&);
+        void                slotPreparedExpired();
 
     private:
+        friend class AudioThread;
+
         MessageWin(const KAEvent*, const DateTime& alarmDateTime, const QStringList& errmsgs,
                    const QString& dontShowAgain);
         void                initView();
+        void                initPreActionView();
         QString             dateTimeToDisplay();
         void                displayComplete();
         void                setButtonsReadOnly(bool);
@@ -137,12 +153,15 @@ class MessageWin : public MainWindowBase
         void                redisplayAlarm();
         static bool         reinstateFromDisplaying(const KCalCore::Event::Ptr&, KAEvent&, Akonadi::Collection&, bool& showEdit, bool& showDefer);
         static bool         isSpread(const QPoint& topLeft);
+        static void         startQueuedAudio();
 
         static QList<MessageWin*>      mWindowList;    // list of existing message windows
+        static QList<MessageWin*>      mPreparedWindows; // hidden windows prepared for imminent alarms
+        static QList<MessageWin*>      mPreActionWindows; // windows showing progress of pre-alarm actions
         static QMap<EventId, unsigned> mErrorMessages; // error messages currently displayed, by event ID
         static bool         mRedisplayed;     // redisplayAlarms() was called
         // Sound file playing
-        static QPointer<AudioThread> mAudioThread;   // thread to play audio file
+        static QList<QPointer<MessageWin> > mAudioQueue;   // windows waiting to play their audio files
         // Properties needed by readProperties()
         QString             mMessage;
         QFont               mFont;
@@ -178,9 +197,13 @@ class MessageWin : public MainWindowBase
         PushButton*         mEditButton;
         PushButton*         mDeferButton;
         PushButton*         mSilenceButton;
+        QPointer<AudioThread> mAudioThread;   // thread to play this window's audio file
+        QElapsedTimer       mAudioLatency;    // time since audio play was requested
+        KDateTime           mPreparedTrigger; // trigger time of the alarm this window was prepared for
         PushButton*         mKAlarmButton;
         PushButton*         mKMailButton;
         MessageText*        mCommandText;     // shows output from command
+        MessageText*        mPreActionText;   // shows output from pre-alarm action
         QCheckBox*          mDontShowAgainCheck;
         EditAlarmDlg*       mEditDlg;         // alarm edit dialog invoked by Edit button
         DeferAlarmDlg*      mDeferDlg;
@@ -189,6 +212,7 @@ class MessageWin : public MainWindowBase
         int                 mScreenNumber;    // screen to display on, or -1 for default
         bool                mAlwaysHide;      // the window should never be displayed
         bool                mErrorWindow;     // the window is simply an error message
+        bool                mPreAction;       // the window shows progress of the pre-alarm action
         bool                mInitialised;     // initView() has been called to create the window's widgets
         bool                mNoPostAction;    // don't execute any post-alarm action
         bool                mRecreating;      // window is about to be deleted and immediately recreated
@@ -21,10 +21,16 @@
 #ifndef MESSAGEWIN_P_H
 #define MESSAGEWIN_P_H
 
+#include <kpimtextedit/texttospeech.h>
 #include <phonon/phononnamespace.h>
 #include <phonon/path.h>
 #include <QThread>
 #include <QMutex>
+#include <QList>
+#include <QQueue>
+#include <QElapsedTimer>
+
+class QTimer;
 
 class MessageWin;
 
@@ -34,12 +40,14 @@ class AudioThread : public QThread
 {
         Q_OBJECT
     public:
-        AudioThread(MessageWin* parent, const QString& audioFile, float volume, float fadeVolume, int fadeSeconds, int repeatPause);
+        AudioThread(QObject* parent, const QString& audioFile, float volume, float fadeVolume, int fadeSeconds, int repeatPause);
         ~AudioThread();
         void    stop(bool wait = false);
+        bool    yield();
+        bool    yielded() const;
         QString error() const;
 
-        static MessageWin*   mAudioOwner;    // window which owns the unique AudioThread
+        static QList<AudioThread*> mInstances;  // all existing audio threads
 
     Q_SIGNALS:
         void    readyToPlay();
@@ -64,6 +72,41 @@ class AudioThread : public QThread
         QString              mError;
         bool                 mPlayedOnce;   // the sound file has started playing at least once
         bool                 mPausing;      // currently pausing between repeats
+        bool                 mYield;        // stop repeating to let a queued sound play
+};
+
+/*=============================================================================
+= Class: SpeechQueue
+= Speaks alarm messages one at a time, in the order in which they were queued.
+=============================================================================*/
+class SpeechQueue : public QObject
+{
+        Q_OBJECT
+    public:
+        static SpeechQueue* instance();
+        static void warmUp();
+        void    say(const QString& text);
+
+    private Q_SLOTS:
+        void    stateChanged(KPIMTextEdit::TextToSpeech::State);
+        void    speakNext();
+        void    utteranceDone();
+
+    private:
+        struct Utterance
+        {
+            QString       text;
+            QElapsedTimer queued;    // time since the utterance was queued
+            QElapsedTimer started;   // time since speaking started
+        };
+        SpeechQueue();
+
+        static SpeechQueue* mInstance;
+        QQueue<Utterance>    mQueue;          // utterances waiting to be spoken
+        Utterance            mCurrent;        // utterance currently being spoken
+        QTimer*              mWatchdog;       // timer in case completion is never signalled
+        bool                 mSpeaking;       // an utterance is currently being spoken
+        bool                 mErrorShowing;   // error message is currently displayed
 };
 
 #endif // MESSAGEWIN_P_H
@@ -154,47 +154,32 @@ KAlarmPrefDlg::KAlarmPrefDlg()
     setFaceType(List);
     mTabScrollGroup = new StackedScrollGroup(this, this);
 
-    mMiscPage = new MiscPrefTab(mTabScrollGroup);
-    mMiscPageItem = new KPageWidgetItem(mMiscPage, i18nc("@title:tab General preferences", "General"));
-    mMiscPageItem->setHeader(i18nc("@title General preferences", "General"));
-    mMiscPageItem->setIcon(QIcon::fromTheme(QStringLiteral("preferences-other")));
-    addPage(mMiscPageItem);
-
-    mTimePage = new TimePrefTab(mTabScrollGroup);
-    mTimePageItem = new KPageWidgetItem(mTimePage, i18nc("@title:tab", "Time & Date"));
-    mTimePageItem->setHeader(i18nc("@title", "Time and Date"));
-    mTimePageItem->setIcon(QIcon::fromTheme(QStringLiteral("preferences-system-time")));
-    addPage(mTimePageItem);
-
-    mStorePage = new StorePrefTab(mTabScrollGroup);
-    mStorePageItem = new KPageWidgetItem(mStorePage, i18nc("@title:tab", "Storage"));
-    mStorePageItem->setHeader(i18nc("@title", "Alarm Storage"));
-    mStorePageItem->setIcon(QIcon::fromTheme(QStringLiteral("system-file-manager")));
-    addPage(mStorePageItem);
-
-    mEmailPage = new EmailPrefTab(mTabScrollGroup);
-    mEmailPageItem = new KPageWidgetItem(mEmailPage, i18nc("@title:tab Email preferences", "Email"));
-    mEmailPageItem->setHeader(i18nc("@title", "Email Alarm Settings"));
-    mEmailPageItem->setIcon(QIcon::fromTheme(QStringLiteral("internet-mail")));
-    addPage(mEmailPageItem);
-
-    mViewPage = new ViewPrefTab(mTabScrollGroup);
-    mViewPageItem = new KPageWidgetItem(mViewPage, i18nc("@title:tab", "View"));
-    mViewPageItem->setHeader(i18nc("@title", "View Settings"));
-    mViewPageItem->setIcon(QIcon::fromTheme(QStringLiteral("preferences-desktop-theme")));
-    addPage(mViewPageItem);
-
-    mEditPage = new EditPrefTab(mTabScrollGroup);
-    mEditPageItem = new KPageWidgetItem(mEditPage, i18nc("@title:tab", "Edit"));
-    mEditPageItem->setHeader(i18nc("@title", "Default Alarm Edit Settings"));
-    mEditPageItem->setIcon(QIcon::fromTheme(QStringLiteral("document-properties")));
-    addPage(mEditPageItem);
+    // Only create the contents of each page when it is first displayed
+    mMiscPage  = nullptr;
+    mTimePage  = nullptr;
+    mStorePage = nullptr;
+    mEmailPage = nullptr;
+    mViewPage  = nullptr;
+    mEditPage  = nullptr;
+    mMiscPageItem  = addEmptyPage(i18nc("@title:tab General preferences", "General"),
+                                  i18nc("@title General preferences", "General"), QStringLiteral("preferences-other"));
+    mTimePageItem  = addEmptyPage(i18nc("@title:tab", "Time & Date"),
+                                  i18nc("@title", "Time and Date"), QStringLiteral("preferences-system-time"));
+    mStorePageItem = addEmptyPage(i18nc("@title:tab", "Storage"),
+                                  i18nc("@title", "Alarm Storage"), QStringLiteral("system-file-manager"));
+    mEmailPageItem = addEmptyPage(i18nc("@title:tab Email preferences", "Email"),
+                                  i18nc("@title", "Email Alarm Settings"), QStringLiteral("internet-mail"));
+    mViewPageItem  = addEmptyPage(i18nc("@title:tab", "View"),
+                                  i18nc("@title", "View Settings"), QStringLiteral("preferences-desktop-theme"));
+    mEditPageItem  = addEmptyPage(i18nc("@title:tab", "Edit"),
+                                  i18nc("@title", "Default Alarm Edit Settings"), QStringLiteral("document-properties"));
+    createPage(mMiscPageItem);
+    connect(this, &KPageDialog::currentPageChanged, this, &KAlarmPrefDlg::slotPageChanged);
     connect(button(QDialogButtonBox::Ok), &QAbstractButton::clicked, this, &KAlarmPrefDlg::slotOk);
     connect(button(QDialogButtonBox::Cancel), &QAbstractButton::clicked, this, &KAlarmPrefDlg::slotCancel);
     connect(button(QDialogButtonBox::Apply), &QAbstractButton::clicked, this, &KAlarmPrefDlg::slotApply);
     connect(button(QDialogButtonBox::RestoreDefaults), &QAbstractButton::clicked, this, &KAlarmPrefDlg::slotDefault);
     connect(button(QDialogButtonBox::Help), &QAbstractButton::clicked, this, &KAlarmPrefDlg::slotHelp);
-    restore(false);
     adjustSize();
 }
 
@@ -203,6 +188,80 @@ KAlarmPrefDlg::~KAlarmPrefDlg()
     mInstance = nullptr;
 }
 
+/******************************************************************************
+* Add an empty page to the dialog. Its contents are created by createPage().
+*/
+KPageWidgetItem* KAlarmPrefDlg::addEmptyPage(const QString& name, const QString& header, const QString& icon)
+{
+    QWidget* container = new QWidget;
+    QVBoxLayout* layout = new QVBoxLayout(container);
+    layout->setMargin(0);
+    KPageWidgetItem* item = new KPageWidgetItem(container, name);
+    item->setHeader(header);
+    item->setIcon(QIcon::fromTheme(icon));
+    addPage(item);
+    return item;
+}
+
+/******************************************************************************
+* Return the contents of a page, or null if they have not been created.
+*/
+PrefsTabBase* KAlarmPrefDlg::page(KPageWidgetItem* item) const
+{
+    if (item == mMiscPageItem)   return mMiscPage;
+    if (item == mTimePageItem)   return mTimePage;
+    if (item == mStorePageItem)  return mStorePage;
+    if (item == mEmailPageItem)  return mEmailPage;
+    if (item == mViewPageItem)   return mViewPage;
+    if (item == mEditPageItem)   return mEditPage;
+    return nullptr;
+}
+
+/******************************************************************************
+* Create the contents of a page, if not already done, and initialise them
+* from the current preference settings.
+*/
+PrefsTabBase* KAlarmPrefDlg::createPage(KPageWidgetItem* item)
+{
+    PrefsTabBase* tab = page(item);
+    if (tab  ||  !item)
+        return tab;
+    if (item == mMiscPageItem)        tab = mMiscPage  = new MiscPrefTab(mTabScrollGroup);
+    else if (item == mTimePageItem)   tab = mTimePage  = new TimePrefTab(mTabScrollGroup);
+    else if (item == mStorePageItem)  tab = mStorePage = new StorePrefTab(mTabScrollGroup);
+    else if (item == mEmailPageItem)  tab = mEmailPage = new EmailPrefTab(mTabScrollGroup);
+    else if (item == mViewPageItem)   tab = mViewPage  = new ViewPrefTab(mTabScrollGroup);
+    else if (item == mEditPageItem)   tab = mEditPage  = new EditPrefTab(mTabScrollGroup);
+    else
+        return nullptr;
+    qCDebug(KALARM_LOG) << item->name();
+    item->widget()->layout()->addWidget(tab);
+    tab->restore(false, true);
+    if (mShown)
+        mTabScrollGroup->adjustSize(true);   // include the new page in the scroll sizing
+    return tab;
+}
+
+/******************************************************************************
+* Return the pages whose contents have been created, in the order in which
+* they should be applied.
+*/
+QList<PrefsTabBase*> KAlarmPrefDlg::pages() const
+{
+    QList<PrefsTabBase*> tabs;
+    tabs << mEmailPage << mViewPage << mEditPage << mStorePage << mTimePage << mMiscPage;
+    tabs.removeAll(nullptr);
+    return tabs;
+}
+
+/******************************************************************************
+* Called when a different page is selected, to create its contents if necessary.
+*/
+void KAlarmPrefDlg::slotPageChanged(KPageWidgetItem* current)
+{
+    createPage(current);
+}
+
 void KAlarmPrefDlg::slotHelp()
 {
     KHelpClient::invokeHelp(QStringLiteral("preferences"));
@@ -212,7 +271,8 @@ void KAlarmPrefDlg::slotHelp()
 void KAlarmPrefDlg::slotApply()
 {
     qCDebug(KALARM_LOG);
-    QString errmsg = mEmailPage->validate();
+    // Only pages which have been displayed can have been changed.
+    QString errmsg = mEmailPage ? mEmailPage->validate() : QString();
     if (!errmsg.isEmpty())
     {
         setCurrentPage(mEmailPageItem);
@@ -222,7 +282,7 @@ void KAlarmPrefDlg::slotApply()
             return;
         }
     }
-    errmsg = mEditPage->validate();
+    errmsg = mEditPage ? mEditPage->validate() : QString();
     if (!errmsg.isEmpty())
     {
         setCurrentPage(mEditPageItem);
@@ -231,12 +291,9 @@ void KAlarmPrefDlg::slotApply()
         return;
     }
     mValid = true;
-    mEmailPage->apply(false);
-    mViewPage->apply(false);
-    mEditPage->apply(false);
-    mStorePage->apply(false);
-    mTimePage->apply(false);
-    mMiscPage->apply(false);
+    const QList<PrefsTabBase*> tabs = pages();
+    for (PrefsTabBase* tab : tabs)
+        tab->apply(false);
     Preferences::self()->save();
 }
 
@@ -270,10 +327,16 @@ void KAlarmPrefDlg::slotDefault()
             restore(true);   // restore all tabs
             break;
         case KMessageBox::No:
-            Preferences::self()->useDefaults(true);
-            static_cast<PrefsTabBase*>(currentPage()->widget())->restore(true, false);
-            Preferences::self()->useDefaults(false);
+        {
+            PrefsTabBase* tab = createPage(currentPage());
+            if (tab)
+            {
+                Preferences::self()->useDefaults(true);
+                tab->restore(true, false);
+                Preferences::self()->useDefaults(false);
+            }
             break;
+        }
         default:
             break;
     }
@@ -284,13 +347,20 @@ void KAlarmPrefDlg::restore(bool defaults)
 {
     qCDebug(KALARM_LOG) << (defaults ? "defaults" : "");
     if (defaults)
+    {
+        // All pages must be reset to their defaults, so that the defaults
+        // will be saved even for pages which have not been displayed.
+        createPage(mEmailPageItem);
+        createPage(mViewPageItem);
+        createPage(mEditPageItem);
+        createPage(mStorePageItem);
+        createPage(mTimePageItem);
+        createPage(mMiscPageItem);
         Preferences::self()->useDefaults(true);
-    mEmailPage->restore(defaults, true);
-    mViewPage->restore(defaults, true);
-    mEditPage->restore(defaults, true);
-    mStorePage->restore(defaults, true);
-    mTimePage->restore(defaults, true);
-    mMiscPage->restore(defaults, true);
+    }
+    const QList<PrefsTabBase*> tabs = pages();
+    for (PrefsTabBase* tab : tabs)
+        tab->restore(defaults, true);
     if (defaults)
         Preferences::self()->useDefaults(false);
 }
@@ -29,6 +29,7 @@ class ViewPrefTab;
 class StorePrefTab;
 class TimePrefTab;
 class MiscPrefTab;
+class PrefsTabBase;
 class StackedScrollGroup;
 
 
@@ -66,8 +67,15 @@ class KAlarmPrefDlg : public KPageDialog
         virtual void slotDefault();
         virtual void slotCancel();
 
+    private Q_SLOTS:
+        void         slotPageChanged(KPageWidgetItem* current);
+
     private:
         KAlarmPrefDlg();
+        KPageWidgetItem* addEmptyPage(const QString& name, const QString& header, const QString& icon);
+        PrefsTabBase* page(KPageWidgetItem*) const;
+        PrefsTabBase* createPage(KPageWidgetItem*);
+        QList<PrefsTabBase*> pages() const;
         void         restore(bool defaults);
 
         static KAlarmPrefDlg* mInstance;
@@ -21,12 +21,14 @@
 #include "kalarm.h"
 #include "templatepickdlg.h"
 
+#include "akonadimodel.h"
 #include "functions.h"
 #include "shellprocess.h"
 #include "templatelistview.h"
 
 #include <KLocalizedString>
 
+#include <QLineEdit>
 #include <QVBoxLayout>
 #include <QResizeEvent>
 #include <QDialogButtonBox>
@@ -35,6 +37,7 @@
 
 static const char TMPL_PICK_DIALOG_NAME[] = "TemplatePickDialog";
 
+TemplateListModel* TemplatePickDlg::mListFilterModel = nullptr;
 
 TemplatePickDlg::TemplatePickDlg(KAEvent::Actions type, QWidget* parent)
     : QDialog(parent)
@@ -54,19 +57,22 @@ TemplatePickDlg::TemplatePickDlg(KAEvent::Actions type, QWidget* parent)
     QVBoxLayout* topLayout = new QVBoxLayout(topWidget);
     topLayout->setMargin(0);
 
+    mFilterEdit = new QLineEdit(topWidget);
+    mFilterEdit->setPlaceholderText(i18nc("@info:placeholder", "Search templates"));
+    mFilterEdit->setClearButtonEnabled(true);
+    mFilterEdit->setWhatsThis(i18nc("@info:whatsthis", "Enter text to show only templates whose names contain it."));
+    connect(mFilterEdit, &QLineEdit::textChanged, this, &TemplatePickDlg::slotFilterTextChanged);
+    topLayout->addWidget(mFilterEdit);
+
     // Display the list of templates, but exclude command alarms if in kiosk mode.
-    KAEvent::Actions shown = KAEvent::ACT_ALL;
     if (!ShellProcess::authorised())
-    {
         type = static_cast<KAEvent::Actions>(type & ~KAEvent::ACT_COMMAND);
-        shown = static_cast<KAEvent::Actions>(shown & ~KAEvent::ACT_COMMAND);
-    }
-    mListFilterModel = new TemplateListModel(this);
-    mListFilterModel->setAlarmActionsEnabled(type);
-    mListFilterModel->setAlarmActionFilter(shown);
+    TemplateListModel* model = listModel();
+    model->setNameFilter(QString());
+    model->setAlarmActionsEnabled(type);
     mListView = new TemplateListView(topWidget);
     mainLayout->addWidget(mListView);
-    mListView->setModel(mListFilterModel);
+    mListView->setModel(model);
     mListView->sortByColumn(TemplateListModel::TemplateNameColumn, Qt::AscendingOrder);
     mListView->setSelectionMode(QAbstractItemView::SingleSelection);
     mListView->setWhatsThis(i18nc("@info:whatsthis", "Select a template to base the new alarm on."));
@@ -76,12 +82,40 @@ TemplatePickDlg::TemplatePickDlg(KAEvent::Actions type, QWidget* parent)
     topLayout->addWidget(mListView);
 
     slotSelectionChanged();        // enable or disable the OK button
+    mFilterEdit->setFocus();
 
     QSize s;
     if (KAlarm::readConfigWindowSize(TMPL_PICK_DIALOG_NAME, s))
         resize(s);
 }
 
+/******************************************************************************
+* Destructor. Clear the search text from the shared model, so that it doesn't
+* maintain a name index while no dialog is using it.
+*/
+TemplatePickDlg::~TemplatePickDlg()
+{
+    if (mListFilterModel)
+        mListFilterModel->setNameFilter(QString());
+}
+
+/******************************************************************************
+* Return the template list model shared by all dialog instances, creating it
+* if necessary. Command alarms are excluded if in kiosk mode.
+*/
+TemplateListModel* TemplatePickDlg::listModel()
+{
+    if (!mListFilterModel)
+    {
+        KAEvent::Actions shown = KAEvent::ACT_ALL;
+        if (!ShellProcess::authorised())
+            shown = static_cast<KAEvent::Actions>(shown & ~KAEvent::ACT_COMMAND);
+        mListFilterModel = new TemplateListModel(AkonadiModel::instance());
+        mListFilterModel->setAlarmActionFilter(shown);
+    }
+    return mListFilterModel;
+}
+
 /******************************************************************************
 * Return the currently selected alarm template, or 0 if none.
 */
@@ -102,6 +136,20 @@ void TemplatePickDlg::slotSelectionChanged()
     mOkButton->setEnabled(enable);
 }
 
+/******************************************************************************
+* Called when the search text changes.
+* Show only templates whose names contain the text, and if none is selected,
+* select the first one.
+*/
+void TemplatePickDlg::slotFilterTextChanged(const QString& text)
+{
+    mListFilterModel->setNameFilter(text);
+    QItemSelectionModel* selection = mListView->selectionModel();
+    if (!selection->hasSelection()  &&  mListFilterModel->rowCount())
+        selection->select(mListFilterModel->index(0, 0), QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
+    slotSelectionChanged();
+}
+
 /******************************************************************************
 * Called when the dialog's size has changed.
 * Records the new size in the config file.
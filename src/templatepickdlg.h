@@ -23,6 +23,7 @@
 #include <kalarmcal/kaevent.h>
 
 #include <QDialog>
+class QLineEdit;
 class QPushButton;
 class QResizeEvent;
 namespace KCal { class Event; }
@@ -36,13 +37,18 @@ class TemplatePickDlg : public QDialog
         Q_OBJECT
     public:
         explicit TemplatePickDlg(KAEvent::Actions, QWidget* parent = nullptr);
+        ~TemplatePickDlg();
         KAEvent        selectedTemplate() const;
     protected:
         void           resizeEvent(QResizeEvent*) override;
     private Q_SLOTS:
         void           slotSelectionChanged();
+        void           slotFilterTextChanged(const QString&);
     private:
-        TemplateListModel* mListFilterModel;
+        static TemplateListModel* listModel();
+
+        static TemplateListModel* mListFilterModel;   // shared by all instances
+        QLineEdit*         mFilterEdit;
         TemplateListView*  mListView;
         QPushButton*       mOkButton;
 };
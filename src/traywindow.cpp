@@ -73,6 +73,7 @@ TrayWindow::TrayWindow(MainWindow* parent)
       mAssocMainWindow(parent),
       mAlarmsModel(nullptr),
       mStatusUpdateTimer(new QTimer(this)),
+      mToolTipUpdateTimer(nullptr),
       mHaveDisabledAlarms(false)
 {
     qCDebug(KALARM_LOG);
@@ -132,8 +133,9 @@ TrayWindow::TrayWindow(MainWindow* parent)
     mToolTipUpdateTimer->setSingleShot(true);
     connect(mToolTipUpdateTimer, &QTimer::timeout, this, &TrayWindow::updateToolTip);
 
-    // Update every minute to show accurate deadlines
+    // Update every minute to show accurate deadlines, while the tooltip shows any alarms
     MinuteTimer::connect(mToolTipUpdateTimer, SLOT(start()));
+    MinuteTimer::setSuspended(mToolTipUpdateTimer, !theApp()->alarmsEnabled() || !Preferences::tooltipAlarmCount());
 
     // Update when alarms are modified
     connect(AlarmListModel::all(), SIGNAL(dataChanged(QModelIndex,QModelIndex)),
@@ -154,8 +156,12 @@ TrayWindow::TrayWindow(MainWindow* parent)
     Preferences::connect(SIGNAL(autoHideSystemTrayChanged(int)), this, SLOT(updateStatus()));
     updateStatus();
 
-    // Update when tooltip preferences are modified
+    // Update when tooltip preferences are modified. The configuration change
+    // notification is also needed because tooltipPreferencesChanged() is not
+    // emitted; updating the tooltip re-evaluates whether minute updates are
+    // needed, in case the number of alarms to show has changed.
     Preferences::connect(SIGNAL(tooltipPreferencesChanged()), mToolTipUpdateTimer, SLOT(start()));
+    connect(Preferences::self(), &KCoreConfigSkeleton::configChanged, mToolTipUpdateTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
 }
 
 TrayWindow::~TrayWindow()
@@ -321,6 +327,11 @@ void TrayWindow::updateToolTip()
     QString subTitle;
     if (enabled && Preferences::tooltipAlarmCount())
         subTitle = tooltipAlarmText();
+    if (mToolTipUpdateTimer)
+    {
+        // The tooltip only needs updating every minute if it shows alarms
+        MinuteTimer::setSuspended(mToolTipUpdateTimer, !enabled || !Preferences::tooltipAlarmCount());
+    }
 
     if (!enabled)
         subTitle = i18n("Disabled");